@@ -0,0 +1,3 @@
+SOURCES	= $(wildcard *.c) $(filter-out ../../src/main.c, $(wildcard ../../src/*.c))
+
+CFLAGS = -I./ -I../../src
@@ -0,0 +1,421 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <MLX90640_API.h>
+#include "utilities.h"
+#include "common.h"
+#include "mlx90640-conversion.h"
+#include "mlx90640-fixed-point.h"
+
+typedef enum
+{
+	kDifferentialHarnessConstantDefaultRepetitions	= 200,
+	kDifferentialHarnessConstantInitialFrames	= 64,
+} DifferentialHarnessConstant;
+
+typedef enum
+{
+	kDifferentialHarnessKernelReference,
+	kDifferentialHarnessKernelFloat,
+	kDifferentialHarnessKernelDouble,
+	kDifferentialHarnessKernelFixedPoint,
+} DifferentialHarnessKernel;
+
+typedef struct DifferentialHarnessVariant
+{
+	const char *			name;
+	DifferentialHarnessKernel	kernel;
+	MLX90640RootPrecision		rootPrecision;
+} DifferentialHarnessVariant;
+
+typedef struct DifferentialHarnessError
+{
+	double		maxAbsoluteError;
+	double		sumAbsoluteError;
+	uint64_t	maxUlpDistance;
+	size_t		pixelCount;
+	size_t		invalidCount;
+} DifferentialHarnessError;
+
+static const DifferentialHarnessVariant	kVariants[] = {
+	{ .name = "melexis",		.kernel = kDifferentialHarnessKernelReference,	.rootPrecision = kMLX90640RootPrecisionExact },
+	{ .name = "float/exact",	.kernel = kDifferentialHarnessKernelFloat,	.rootPrecision = kMLX90640RootPrecisionExact },
+	{ .name = "float/float",	.kernel = kDifferentialHarnessKernelFloat,	.rootPrecision = kMLX90640RootPrecisionFloat },
+	{ .name = "float/fast",		.kernel = kDifferentialHarnessKernelFloat,	.rootPrecision = kMLX90640RootPrecisionFast },
+	{ .name = "double/exact",	.kernel = kDifferentialHarnessKernelDouble,	.rootPrecision = kMLX90640RootPrecisionExact },
+	{ .name = "double/float",	.kernel = kDifferentialHarnessKernelDouble,	.rootPrecision = kMLX90640RootPrecisionFloat },
+	{ .name = "double/fast",	.kernel = kDifferentialHarnessKernelDouble,	.rootPrecision = kMLX90640RootPrecisionFast },
+	{ .name = "fixed",		.kernel = kDifferentialHarnessKernelFixedPoint,	.rootPrecision = kMLX90640RootPrecisionExact },
+};
+
+/*
+ *	Indices in `kVariants` of the two references: the unmodified Melexis
+ *	kernel and the float kernel of this example.
+ */
+static const size_t	kReferenceVariant = 0;
+static const size_t	kFloatVariant = 1;
+
+static uint16_t	eeData[kMLX90640ConstantEEDataBufferSize];
+static uint16_t *	rawDataFrames;
+static float *	trs;
+static double *	referenceTo;
+static double *	floatTo;
+static uint16_t	mlx90640ToCentiKelvin[kMLX90640ConstantFrameBufferSize];
+static MLX90640FixedPointParams	fixedPointParams;
+static float	mlx90640To[kMLX90640ConstantFrameBufferSize];
+static double	mlx90640ToDouble[kMLX90640ConstantFrameBufferSize];
+
+/**
+ *	@brief	Read all raw frames of a recording, as CSV or, if the file name ends in `.bin`, as
+ *		little-endian uint16 words, into `rawDataFrames`, and compute the reflected temperature of each.
+ *
+ *	@param	path		: Path of the recording.
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@return	size_t		: Number of frames read.
+ */
+static size_t	readRecording(const char *  path, const paramsMLX90640 *  params);
+
+/**
+ *	@brief	Convert one raw frame with the given variant into `mlx90640ToDouble`. Pixels of the
+ *		other sub-page, and pixels the fixed-point kernel flags as invalid, are NaN.
+ *
+ *	@param	variant		: Kernel variant.
+ *	@param	frame		: Index of the raw frame.
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@param	arguments	: Pointer to command line arguments struct.
+ */
+static void	convertFrame(const DifferentialHarnessVariant *  variant, size_t frame, const paramsMLX90640 *  params, const CommandLineArguments *  arguments);
+
+/**
+ *	@brief	Accumulate the error of `mlx90640ToDouble` against a reference frame. Pixels that are NaN
+ *		in the reference were not converted and are skipped.
+ *
+ *	@param	reference	: Reference temperatures of the frame.
+ *	@param	error		: Error to accumulate into.
+ */
+static void	accumulateError(const double *  reference, DifferentialHarnessError *  error);
+
+/**
+ *	@brief	Distance in units in the last place of single precision between two values.
+ *
+ *	@param	a		: First value.
+ *	@param	b		: Second value.
+ *	@return	uint64_t	: Number of floats between `a` and `b` after rounding them to float.
+ */
+static uint64_t	floatUlpDistance(double a, double b);
+
+int
+main(int argc, char *  argv[])
+{
+	CommandLineArguments	arguments;
+	paramsMLX90640		mlx90640Params = { 0 };
+	size_t			frameCount;
+	size_t			repetitions;
+
+	if (getCommandLineArguments(argc, argv, &arguments))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 *	All kernels are compared on particle values.
+	 */
+	arguments.modelQuantizationError = false;
+	repetitions = (arguments.common.numberOfMonteCarloIterations > 1) ? arguments.common.numberOfMonteCarloIterations : kDifferentialHarnessConstantDefaultRepetitions;
+
+	if (readUint16DataFromCSV(eeData, 0, kMLX90640ConstantEEDataBufferSize, arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MLX90640_ExtractParameters(eeData, &mlx90640Params))
+	{
+		fprintf(stderr, "Error in extracting parameters from EE\n");
+		exit(EXIT_FAILURE);
+	}
+
+	MLX90640_PrepareFixedPointParameters(&mlx90640Params, arguments.emissivity, kMLX90640ConstantTaShift, &fixedPointParams);
+
+	frameCount = readRecording(arguments.rawDataPath, &mlx90640Params);
+	if (frameCount == 0)
+	{
+		fprintf(stderr, "Error in reading sensor raw data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	referenceTo = malloc(frameCount * sizeof(mlx90640ToDouble));
+	floatTo = malloc(frameCount * sizeof(mlx90640ToDouble));
+	if ((referenceTo == NULL) || (floatTo == NULL))
+	{
+		fprintf(stderr, "Error in allocating reference temperatures\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (size_t f = 0; f < frameCount; f++)
+	{
+		convertFrame(&kVariants[kReferenceVariant], f, &mlx90640Params, &arguments);
+		memcpy(&referenceTo[f * kMLX90640ConstantFrameBufferSize], mlx90640ToDouble, sizeof(mlx90640ToDouble));
+		convertFrame(&kVariants[kFloatVariant], f, &mlx90640Params, &arguments);
+		memcpy(&floatTo[f * kMLX90640ConstantFrameBufferSize], mlx90640ToDouble, sizeof(mlx90640ToDouble));
+	}
+
+	printf("Frames: %zu, repetitions: %zu, references: %s, %s (-q)\n", frameCount, repetitions, kVariants[kReferenceVariant].name, kVariants[kFloatVariant].name);
+	printf(
+		"%-14s %12s %10s %16s %16s %14s %18s %8s\n",
+		"kernel",
+		"frames/s",
+		"ns/pixel",
+		"max error (mK)",
+		"mean error (mK)",
+		"max ULP (f32)",
+		"max vs float (mK)",
+		"invalid");
+
+	for (size_t v = 0; v < sizeof(kVariants) / sizeof(kVariants[0]); v++)
+	{
+		const DifferentialHarnessVariant *	variant = &kVariants[v];
+		DifferentialHarnessError		referenceError = { 0 };
+		DifferentialHarnessError		floatError = { 0 };
+		uint64_t				start;
+		uint64_t				end;
+
+		for (size_t f = 0; f < frameCount; f++)
+		{
+			convertFrame(variant, f, &mlx90640Params, &arguments);
+			accumulateError(&referenceTo[f * kMLX90640ConstantFrameBufferSize], &referenceError);
+			accumulateError(&floatTo[f * kMLX90640ConstantFrameBufferSize], &floatError);
+		}
+
+		start = getMonotonicTimeNanoseconds();
+		for (size_t r = 0; r < repetitions; r++)
+		{
+			for (size_t f = 0; f < frameCount; f++)
+			{
+				convertFrame(variant, f, &mlx90640Params, &arguments);
+			}
+			doNotOptimize((void *)mlx90640ToDouble);
+		}
+		end = getMonotonicTimeNanoseconds();
+
+		/*
+		 *	Each frame holds one sub-page, i.e., half of the pixels.
+		 */
+		printf(
+			"%-14s %12.1f %10.2f %16.3f %16.3f %14" PRIu64 " %18.3f %8zu\n",
+			variant->name,
+			(repetitions * frameCount) / ((end - start) / 1e9),
+			(end - start) / ((double)repetitions * frameCount * kMLX90640ConstantFrameBufferSize / 2),
+			referenceError.maxAbsoluteError * 1000,
+			(referenceError.pixelCount > 0) ? referenceError.sumAbsoluteError / referenceError.pixelCount * 1000 : 0,
+			referenceError.maxUlpDistance,
+			floatError.maxAbsoluteError * 1000,
+			referenceError.invalidCount);
+	}
+
+	free(rawDataFrames);
+	free(trs);
+	free(referenceTo);
+	free(floatTo);
+
+	return 0;
+}
+
+static size_t
+readRecording(const char *  path, const paramsMLX90640 *  params)
+{
+	size_t	pathLength = strlen(path);
+	bool	isBinary = (pathLength > 4) && (strcmp(&path[pathLength - 4], ".bin") == 0);
+	FILE *	file = NULL;
+	size_t	capacity = 0;
+	size_t	frameCount = 0;
+
+	if (isBinary && ((file = fopen(path, "rb")) == NULL))
+	{
+		return 0;
+	}
+
+	for (;;)
+	{
+		uint16_t *	frame;
+
+		if (frameCount == capacity)
+		{
+			uint16_t *	grownFrames;
+			float *		grownTrs;
+
+			capacity = (capacity == 0) ? kDifferentialHarnessConstantInitialFrames : 2 * capacity;
+			grownFrames = realloc(rawDataFrames, capacity * kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t));
+			if (grownFrames != NULL)
+			{
+				rawDataFrames = grownFrames;
+			}
+			grownTrs = realloc(trs, capacity * sizeof(float));
+			if (grownTrs != NULL)
+			{
+				trs = grownTrs;
+			}
+			if ((grownFrames == NULL) || (grownTrs == NULL))
+			{
+				fprintf(stderr, "Error in allocating raw frames\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		frame = &rawDataFrames[frameCount * kMLX90640ConstantRawFrameBufferSize];
+		if (isBinary)
+		{
+			uint8_t	bytes[kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t)];
+
+			if (fread(bytes, sizeof(bytes), 1, file) != 1)
+			{
+				break;
+			}
+			for (size_t i = 0; i < kMLX90640ConstantRawFrameBufferSize; i++)
+			{
+				frame[i] = (uint16_t)(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+			}
+		}
+		else if (readUint16DataFromCSV(frame, frameCount, kMLX90640ConstantRawFrameBufferSize, path) <= 0)
+		{
+			break;
+		}
+
+		trs[frameCount] = MLX90640_GetTa(frame, params) - kMLX90640ConstantTaShift;
+		frameCount++;
+	}
+
+	if (file != NULL)
+	{
+		fclose(file);
+	}
+
+	return frameCount;
+}
+
+static void
+convertFrame(const DifferentialHarnessVariant *  variant, size_t frame, const paramsMLX90640 *  params, const CommandLineArguments *  arguments)
+{
+	uint16_t *	rawDataFrame = &rawDataFrames[frame * kMLX90640ConstantRawFrameBufferSize];
+
+	switch (variant->kernel)
+	{
+	case kDifferentialHarnessKernelDouble:
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640ToDouble[i] = NAN;
+		}
+		MLX90640_CalculateTo_UTDouble(rawDataFrame, params, arguments->emissivity, NULL, trs[frame], mlx90640ToDouble, arguments->modelQuantizationError, variant->rootPrecision);
+		return;
+
+	case kDifferentialHarnessKernelFixedPoint:
+		/*
+		 *	The fixed-point kernel writes 0 for invalid pixels and for
+		 *	pixels of the other sub-page alike.
+		 */
+		memset(mlx90640ToCentiKelvin, 0, sizeof(mlx90640ToCentiKelvin));
+		MLX90640_CalculateTo_FixedPoint(rawDataFrame, &fixedPointParams, mlx90640ToCentiKelvin);
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640ToDouble[i] = (mlx90640ToCentiKelvin[i] == 0) ? NAN : mlx90640ToCentiKelvin[i] / 100.0 - 273.15;
+		}
+		return;
+
+	case kDifferentialHarnessKernelReference:
+	case kDifferentialHarnessKernelFloat:
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640To[i] = NAN;
+		}
+
+		if (variant->kernel == kDifferentialHarnessKernelReference)
+		{
+			MLX90640_CalculateTo(rawDataFrame, params, arguments->emissivity, trs[frame], mlx90640To);
+		}
+		else
+		{
+			MLX90640_CalculateTo_UT(rawDataFrame, params, arguments->emissivity, NULL, trs[frame], mlx90640To, arguments->modelQuantizationError, variant->rootPrecision);
+		}
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640ToDouble[i] = mlx90640To[i];
+		}
+		return;
+	}
+}
+
+static void
+accumulateError(const double *  reference, DifferentialHarnessError *  error)
+{
+	for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+	{
+		double	absoluteError;
+
+		if (isnan(reference[i]))
+		{
+			continue;
+		}
+
+		if (isnan(mlx90640ToDouble[i]))
+		{
+			error->invalidCount++;
+			continue;
+		}
+
+		absoluteError = fabs(mlx90640ToDouble[i] - reference[i]);
+		error->maxAbsoluteError = fmax(error->maxAbsoluteError, absoluteError);
+		error->sumAbsoluteError += absoluteError;
+		error->maxUlpDistance = (floatUlpDistance(mlx90640ToDouble[i], reference[i]) > error->maxUlpDistance)
+						? floatUlpDistance(mlx90640ToDouble[i], reference[i])
+						: error->maxUlpDistance;
+		error->pixelCount++;
+	}
+}
+
+static uint64_t
+floatUlpDistance(double a, double b)
+{
+	float	values[2] = { (float)a, (float)b };
+	int64_t	ordered[2];
+
+	/*
+	 *	Map the sign-magnitude representation of floats onto a monotonic
+	 *	integer line, on which the distance is the number of floats between.
+	 */
+	for (int i = 0; i < 2; i++)
+	{
+		int32_t	bits;
+
+		memcpy(&bits, &values[i], sizeof(bits));
+		ordered[i] = (bits < 0) ? (int64_t)INT32_MIN - bits : bits;
+	}
+
+	return (ordered[0] > ordered[1]) ? (uint64_t)(ordered[0] - ordered[1]) : (uint64_t)(ordered[1] - ordered[0]);
+}
@@ -0,0 +1,323 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+/*
+ *	For asprintf().
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utilities.h"
+#include "common.h"
+#include "frame-reader.h"
+#include "batch-reader.h"
+
+typedef enum
+{
+	kIngestBenchmarkConstantDefaultRepetitions	= 5,
+} IngestBenchmarkConstant;
+
+/*
+ *	Ways of reading the recordings of the directory.
+ */
+typedef enum
+{
+	kIngestMethodSequential,	/* One FrameReader per file, opened and read one after the other */
+	kIngestMethodIoUring,
+	kIngestMethodThreadPool,
+} IngestMethod;
+
+typedef struct IngestResult
+{
+	double		seconds;
+	size_t		frameCount;
+	size_t		byteCount;
+	size_t		failedFileCount;
+	uint64_t	checksum;
+	bool		isFallback;	/* io_uring was requested but unavailable */
+} IngestResult;
+
+static uint16_t		rawDataFrame[kMLX90640ConstantRawFrameBufferSize];
+static char **		paths;
+static size_t		pathCount;
+
+/**
+ *	@brief	List the regular files of the directory into `paths`, in the order of the batch reader.
+ *
+ *	@param	directory	: Directory of recordings.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	listRecordings(const char *  directory);
+
+/**
+ *	@brief	scandir() filter of the entries that can be recordings, as in the batch reader.
+ *
+ *	@param	entry		: Directory entry.
+ *	@return	int		: Non-zero for regular files and entries of unknown type other than "." and "..".
+ */
+static int	isRecordingEntry(const struct dirent *  entry);
+
+/**
+ *	@brief	Drop the recordings from the page cache, so that the next run reads them from the disk.
+ */
+static void	evictRecordings(void);
+
+/**
+ *	@brief	Read and parse every frame of the directory once.
+ *
+ *	@param	method		: How to read the files.
+ *	@param	arguments	: Command-line arguments, for the directory, input format and files in flight.
+ *	@return	IngestResult	: Time, counts and checksum of the frames.
+ */
+static IngestResult	runIngest(IngestMethod method, const CommandLineArguments *  arguments);
+
+/**
+ *	@brief	Fold a frame into a checksum, so that methods can be checked to read the same frames.
+ *
+ *	@param	checksum	: Checksum so far.
+ *	@param	length		: Number of words of the frame.
+ *	@return	uint64_t	: Updated checksum.
+ */
+static uint64_t	addFrameToChecksum(uint64_t checksum, int length);
+
+/**
+ *	@brief	qsort() comparison of two doubles.
+ *
+ *	@param	a		: Pointer to the first value.
+ *	@param	b		: Pointer to the second value.
+ *	@return	int		: Negative, zero or positive as `a` is below, equal to or above `b`.
+ */
+static int	compareDouble(const void *  a, const void *  b);
+
+int
+main(int argc, char *  argv[])
+{
+	CommandLineArguments	arguments;
+	size_t			repetitions;
+	double *		samples;
+	static const char *	kMethodNames[] = { "sequential", "io_uring", "thread pool" };
+
+	if (getCommandLineArguments(argc, argv, &arguments))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	if (!arguments.isRawDataDirectory || (listRecordings(arguments.rawDataPath) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error: -i must be a directory of recordings\n");
+		exit(EXIT_FAILURE);
+	}
+
+	repetitions = (arguments.common.numberOfMonteCarloIterations > 1) ? arguments.common.numberOfMonteCarloIterations : kIngestBenchmarkConstantDefaultRepetitions;
+	samples = calloc(repetitions, sizeof(double));
+	if (samples == NULL)
+	{
+		fprintf(stderr, "Error in allocating benchmark buffers\n");
+		exit(EXIT_FAILURE);
+	}
+
+	printf("Files: %zu, files in flight: %u, repetitions: %zu, median of the runs\n", pathCount, arguments.filesInFlight, repetitions);
+	printf("%-12s %-5s %10s %12s %10s %12s %10s %7s %16s\n", "method", "cache", "seconds", "files/s", "MiB/s", "frames/s", "frames", "failed", "checksum");
+
+	for (int isCold = 0; isCold <= 1; isCold++)
+	{
+		for (IngestMethod method = kIngestMethodSequential; method <= kIngestMethodThreadPool; method++)
+		{
+			IngestResult	result = { 0 };
+			double		seconds;
+
+			/*
+			 *	One untimed run fills the page cache for the warm runs.
+			 */
+			if (!isCold)
+			{
+				runIngest(method, &arguments);
+			}
+
+			for (size_t r = 0; r < repetitions; r++)
+			{
+				if (isCold)
+				{
+					evictRecordings();
+				}
+				result = runIngest(method, &arguments);
+				samples[r] = result.seconds;
+			}
+			qsort(samples, repetitions, sizeof(double), compareDouble);
+			seconds = samples[repetitions / 2];
+
+			printf(
+				"%-12s %-5s %10.4f %12.0f %10.1f %12.0f %10zu %7zu %016" PRIx64 "%s\n",
+				kMethodNames[method],
+				isCold ? "cold" : "warm",
+				seconds,
+				pathCount / seconds,
+				result.byteCount / seconds / (1024 * 1024),
+				result.frameCount / seconds,
+				result.frameCount,
+				result.failedFileCount,
+				result.checksum,
+				result.isFallback ? " (io_uring unavailable, thread pool)" : "");
+		}
+	}
+
+	for (size_t i = 0; i < pathCount; i++)
+	{
+		free(paths[i]);
+	}
+	free(paths);
+	free(samples);
+
+	return 0;
+}
+
+static CommonConstantReturnType
+listRecordings(const char *  directory)
+{
+	struct dirent **	entries;
+	int			entryCount = scandir(directory, &entries, isRecordingEntry, alphasort);
+
+	if (entryCount < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	paths = calloc(entryCount + 1, sizeof(char *));
+	for (int i = 0; i < entryCount; i++)
+	{
+		if ((paths != NULL) && (asprintf(&paths[pathCount], "%s/%s", directory, entries[i]->d_name) >= 0))
+		{
+			pathCount++;
+		}
+		free(entries[i]);
+	}
+	free(entries);
+
+	return ((paths != NULL) && (pathCount == (size_t)entryCount)) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+}
+
+static int
+isRecordingEntry(const struct dirent *  entry)
+{
+	return (entry->d_type == DT_REG) ||
+		((entry->d_type == DT_UNKNOWN) && (strcmp(entry->d_name, ".") != 0) && (strcmp(entry->d_name, "..") != 0));
+}
+
+static void
+evictRecordings(void)
+{
+	for (size_t i = 0; i < pathCount; i++)
+	{
+		int	fd = open(paths[i], O_RDONLY | O_CLOEXEC);
+
+		if (fd >= 0)
+		{
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+	}
+}
+
+static IngestResult
+runIngest(IngestMethod method, const CommandLineArguments *  arguments)
+{
+	IngestResult	result = { .checksum = 0xcbf29ce484222325ULL };
+	uint64_t	begin = getMonotonicTimeNanoseconds();
+	int		length;
+
+	if (method == kIngestMethodSequential)
+	{
+		for (size_t i = 0; i < pathCount; i++)
+		{
+			FrameReader	reader;
+
+			if (frameReaderOpen(&reader, paths[i], arguments->inputFormat) != kCommonConstantReturnTypeSuccess)
+			{
+				result.failedFileCount++;
+				continue;
+			}
+
+			while ((length = frameReaderRead(&reader, rawDataFrame, kMLX90640ConstantRawFrameBufferSize)) >= 0)
+			{
+				result.checksum = addFrameToChecksum(result.checksum, length);
+				result.frameCount++;
+			}
+			result.byteCount += reader.offset;
+			frameReaderClose(&reader);
+		}
+	}
+	else
+	{
+		BatchReader		reader;
+		BatchReaderBackend	backend = (method == kIngestMethodIoUring) ? kBatchReaderBackendIoUring : kBatchReaderBackendThreadPool;
+
+		if (batchReaderOpen(&reader, arguments->rawDataPath, arguments->inputFormat, arguments->filesInFlight, backend) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error in opening the recordings of directory '%s'\n", arguments->rawDataPath);
+			exit(EXIT_FAILURE);
+		}
+		result.isFallback = (reader.backend != backend);
+
+		while ((length = batchReaderRead(&reader, rawDataFrame, kMLX90640ConstantRawFrameBufferSize)) >= 0)
+		{
+			result.checksum = addFrameToChecksum(result.checksum, length);
+			result.frameCount++;
+		}
+		result.byteCount = reader.byteCount;
+		result.failedFileCount = reader.failedFileCount;
+		batchReaderClose(&reader);
+	}
+	result.seconds = (getMonotonicTimeNanoseconds() - begin) * 1e-9;
+
+	return result;
+}
+
+static uint64_t
+addFrameToChecksum(uint64_t checksum, int length)
+{
+	/*
+	 *	FNV-1a over the words of the frame.
+	 */
+	for (int i = 0; i < length; i++)
+	{
+		checksum = (checksum ^ rawDataFrame[i]) * 0x100000001b3ULL;
+	}
+
+	return checksum;
+}
+
+static int
+compareDouble(const void *  a, const void *  b)
+{
+	double	x = *(const double *)a;
+	double	y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
@@ -0,0 +1,219 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <MLX90640_API.h>
+#include "utilities.h"
+#include "common.h"
+#include "mlx90640-conversion.h"
+#include "mlx90640-fixed-point.h"
+
+typedef enum
+{
+	kPrecisionBenchmarkConstantDefaultRepetitions	= 2000,
+	kPrecisionBenchmarkConstantMaxFrames		= 4096,
+} PrecisionBenchmarkConstant;
+
+typedef struct PrecisionBenchmarkVariant
+{
+	const char *		name;
+	MLX90640Precision	precision;
+	MLX90640RootPrecision	rootPrecision;
+} PrecisionBenchmarkVariant;
+
+static const PrecisionBenchmarkVariant	kVariants[] = {
+	{ .name = "double/exact",	.precision = kMLX90640PrecisionDouble,	.rootPrecision = kMLX90640RootPrecisionExact },
+	{ .name = "double/float",	.precision = kMLX90640PrecisionDouble,	.rootPrecision = kMLX90640RootPrecisionFloat },
+	{ .name = "double/fast",	.precision = kMLX90640PrecisionDouble,	.rootPrecision = kMLX90640RootPrecisionFast },
+	{ .name = "float/exact",	.precision = kMLX90640PrecisionFloat,	.rootPrecision = kMLX90640RootPrecisionExact },
+	{ .name = "float/fast",		.precision = kMLX90640PrecisionFloat,	.rootPrecision = kMLX90640RootPrecisionFast },
+	{ .name = "fixed",		.precision = kMLX90640PrecisionFixedPoint, .rootPrecision = kMLX90640RootPrecisionExact },
+};
+
+/*
+ *	Index of the float kernel in `kVariants`, against which the deviation is reported as well.
+ */
+static const size_t	kFloatVariant = 3;
+
+static uint16_t	eeData[kMLX90640ConstantEEDataBufferSize];
+static uint16_t	rawDataFrames[kPrecisionBenchmarkConstantMaxFrames][kMLX90640ConstantRawFrameBufferSize];
+static float	trs[kPrecisionBenchmarkConstantMaxFrames];
+static double	referenceTo[kPrecisionBenchmarkConstantMaxFrames][kMLX90640ConstantFrameBufferSize];
+static double	floatTo[kPrecisionBenchmarkConstantMaxFrames][kMLX90640ConstantFrameBufferSize];
+static uint16_t	mlx90640ToCentiKelvin[kMLX90640ConstantFrameBufferSize];
+static MLX90640FixedPointParams	fixedPointParams;
+static float	mlx90640To[kMLX90640ConstantFrameBufferSize];
+static double	mlx90640ToDouble[kMLX90640ConstantFrameBufferSize];
+
+/**
+ *	@brief	Convert one raw frame with the given variant into `mlx90640ToDouble`.
+ *
+ *	@param	variant		: Kernel variant.
+ *	@param	frame		: Index of the raw frame.
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@param	arguments	: Pointer to command line arguments struct.
+ */
+static void
+convertFrame(const PrecisionBenchmarkVariant *  variant, size_t frame, const paramsMLX90640 *  params, const CommandLineArguments *  arguments)
+{
+	if (variant->precision == kMLX90640PrecisionDouble)
+	{
+		MLX90640_CalculateTo_UTDouble(rawDataFrames[frame], params, arguments->emissivity, NULL, trs[frame], mlx90640ToDouble, arguments->modelQuantizationError, variant->rootPrecision);
+		return;
+	}
+
+	if (variant->precision == kMLX90640PrecisionFixedPoint)
+	{
+		MLX90640_CalculateTo_FixedPoint(rawDataFrames[frame], &fixedPointParams, mlx90640ToCentiKelvin);
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640ToDouble[i] = (mlx90640ToCentiKelvin[i] == 0) ? NAN : mlx90640ToCentiKelvin[i] / 100.0 - 273.15;
+		}
+		return;
+	}
+
+	MLX90640_CalculateTo_UT(rawDataFrames[frame], params, arguments->emissivity, NULL, trs[frame], mlx90640To, arguments->modelQuantizationError, variant->rootPrecision);
+
+	for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+	{
+		mlx90640ToDouble[i] = mlx90640To[i];
+	}
+}
+
+int
+main(int argc, char *  argv[])
+{
+	CommandLineArguments	arguments;
+	paramsMLX90640		mlx90640Params = { 0 };
+	size_t			frameCount = 0;
+	size_t			repetitions;
+
+	if (getCommandLineArguments(argc, argv, &arguments))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	repetitions = (arguments.common.numberOfMonteCarloIterations > 1) ? arguments.common.numberOfMonteCarloIterations : kPrecisionBenchmarkConstantDefaultRepetitions;
+
+	if (readUint16DataFromCSV(eeData, 0, kMLX90640ConstantEEDataBufferSize, arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MLX90640_ExtractParameters(eeData, &mlx90640Params))
+	{
+		fprintf(stderr, "Error in extracting parameters from EE\n");
+		exit(EXIT_FAILURE);
+	}
+
+	MLX90640_PrepareFixedPointParameters(&mlx90640Params, arguments.emissivity, kMLX90640ConstantTaShift, &fixedPointParams);
+
+	while ((frameCount < kPrecisionBenchmarkConstantMaxFrames) &&
+		(readUint16DataFromCSV(rawDataFrames[frameCount], frameCount, kMLX90640ConstantRawFrameBufferSize, arguments.rawDataPath) > 0))
+	{
+		trs[frameCount] = MLX90640_GetTa(rawDataFrames[frameCount], &mlx90640Params) - kMLX90640ConstantTaShift;
+		frameCount++;
+	}
+
+	if (frameCount == 0)
+	{
+		fprintf(stderr, "Error in reading sensor raw data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 *	The first variant is the double precision reference. Every variant starts
+	 *	from a zeroed frame so that pixels of the sub-page not yet converted compare
+	 *	equal.
+	 */
+	memset(mlx90640ToDouble, 0, sizeof(mlx90640ToDouble));
+	for (size_t f = 0; f < frameCount; f++)
+	{
+		convertFrame(&kVariants[0], f, &mlx90640Params, &arguments);
+		memcpy(referenceTo[f], mlx90640ToDouble, sizeof(mlx90640ToDouble));
+	}
+
+	memset(mlx90640ToDouble, 0, sizeof(mlx90640ToDouble));
+	for (size_t f = 0; f < frameCount; f++)
+	{
+		convertFrame(&kVariants[kFloatVariant], f, &mlx90640Params, &arguments);
+		memcpy(floatTo[f], mlx90640ToDouble, sizeof(mlx90640ToDouble));
+	}
+
+	printf("Frames: %zu, repetitions: %zu, reference: %s\n", frameCount, repetitions, kVariants[0].name);
+	printf("%-16s %16s %16s %24s %24s\n", "precision/roots", "frames/s", "ns/pixel", "max deviation (mK)", "max dev. from float (mK)");
+
+	for (size_t v = 0; v < sizeof(kVariants) / sizeof(kVariants[0]); v++)
+	{
+		const PrecisionBenchmarkVariant *	variant = &kVariants[v];
+		double					maxDeviation = 0;
+		double					maxFloatDeviation = 0;
+		uint64_t				start;
+		uint64_t				end;
+		double					seconds;
+
+		memset(mlx90640To, 0, sizeof(mlx90640To));
+		memset(mlx90640ToDouble, 0, sizeof(mlx90640ToDouble));
+		for (size_t f = 0; f < frameCount; f++)
+		{
+			convertFrame(variant, f, &mlx90640Params, &arguments);
+
+			for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+			{
+				maxDeviation = fmax(maxDeviation, fabs(mlx90640ToDouble[i] - referenceTo[f][i]));
+				maxFloatDeviation = fmax(maxFloatDeviation, fabs(mlx90640ToDouble[i] - floatTo[f][i]));
+			}
+		}
+
+		start = getMonotonicTimeNanoseconds();
+		for (size_t r = 0; r < repetitions; r++)
+		{
+			for (size_t f = 0; f < frameCount; f++)
+			{
+				convertFrame(variant, f, &mlx90640Params, &arguments);
+			}
+			doNotOptimize((void *)mlx90640ToDouble);
+		}
+		end = getMonotonicTimeNanoseconds();
+
+		/*
+		 *	Each frame holds one sub-page, i.e., half of the pixels.
+		 */
+		seconds = (end - start) / 1e9;
+		printf(
+			"%-16s %16.1f %16.2f %24.3f %24.3f\n",
+			variant->name,
+			(repetitions * frameCount) / seconds,
+			(end - start) / ((double)repetitions * frameCount * kMLX90640ConstantFrameBufferSize / 2),
+			maxDeviation * 1000,
+			maxFloatDeviation * 1000);
+	}
+
+	return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <MLX90640_API.h>
+#include "utilities.h"
+#include "common.h"
+#include "mlx90640-conversion.h"
+#include "mlx90640-fixed-point.h"
+#include "frame-writer.h"
+
+typedef enum
+{
+	kPrimitivesBenchmarkConstantDefaultRepetitions	= 200,
+	kPrimitivesBenchmarkConstantWarmUpNanoseconds	= 20000000,
+	kPrimitivesBenchmarkConstantMinBatchNanoseconds	= 20000,
+	kPrimitivesBenchmarkConstantMaxBenchmarks	= 64,
+	kPrimitivesBenchmarkConstantMaxNameLength	= 64,
+	kPrimitivesBenchmarkConstantSweepCount		= 10,
+	kPrimitivesBenchmarkConstantEvictionBytes	= 64 * 1024 * 1024,
+	kPrimitivesBenchmarkConstantFormatBufferSize	= 16384,
+} PrimitivesBenchmarkConstant;
+
+typedef enum
+{
+	kPrimitiveReadCSV,
+	kPrimitiveExtractParameters,
+	kPrimitiveGetVdd,
+	kPrimitiveGetTa,
+	kPrimitiveCalculateTo,
+	kPrimitiveCalculateToSweep,
+	kPrimitiveCalculateToFixedPoint,
+	kPrimitiveFormatOutput,
+	kPrimitiveFormatOutputFixed,
+} Primitive;
+
+typedef struct PrimitiveBenchmark
+{
+	char			name[kPrimitivesBenchmarkConstantMaxNameLength];
+	Primitive		primitive;
+	MLX90640Precision	precision;
+	MLX90640RootPrecision	rootPrecision;
+	bool			quantizationError;
+	bool			emissivityMap;
+} PrimitiveBenchmark;
+
+typedef struct PrimitiveStatistics
+{
+	size_t	batch;
+	double	minimum;
+	double	median;
+	double	mean;
+	double	p99;
+	double	relativeStandardDeviation;
+} PrimitiveStatistics;
+
+static uint16_t			eeData[kMLX90640ConstantEEDataBufferSize];
+static uint16_t			rawDataFrame[kMLX90640ConstantRawFrameBufferSize];
+static paramsMLX90640		mlx90640Params;
+static MLX90640FixedPointParams	fixedPointParams;
+static float			tr;
+static float			emissivity;
+static float			emissivityMap[kMLX90640ConstantFrameBufferSize];
+static float			emissivitySweep[kPrimitivesBenchmarkConstantSweepCount];
+static float			mlx90640To[kMLX90640ConstantFrameBufferSize];
+static double			mlx90640ToDouble[kMLX90640ConstantFrameBufferSize];
+static float			emissivitySweepTable[kPrimitivesBenchmarkConstantSweepCount * kMLX90640ConstantFrameBufferSize];
+static uint16_t			mlx90640ToCentiKelvin[kMLX90640ConstantFrameBufferSize];
+static char			formatBuffer[kPrimitivesBenchmarkConstantFormatBufferSize];
+static const char *		rawDataPath;
+static PrimitiveBenchmark	benchmarks[kPrimitivesBenchmarkConstantMaxBenchmarks];
+static size_t			benchmarkCount;
+static uint8_t *		evictionBuffer;
+
+/**
+ *	@brief	Add a benchmark to `benchmarks`.
+ *
+ *	@param	benchmark	: Benchmark description, `name` is ignored.
+ *	@param	name		: Name of the benchmark.
+ */
+static void	addBenchmark(PrimitiveBenchmark benchmark, const char *  name);
+
+/**
+ *	@brief	Run one call of the primitive of a benchmark.
+ *
+ *	@param	benchmark	: Benchmark to run.
+ */
+static void	runPrimitive(const PrimitiveBenchmark *  benchmark);
+
+/**
+ *	@brief	Evict the caches by writing a buffer larger than the last-level cache.
+ */
+static void	evictCaches(void);
+
+/**
+ *	@brief	Time `repetitions` samples of a benchmark. Warm samples time a batch of calls, sized so that
+ *		a batch takes long enough to hide the clock overhead, after a warm-up. Cold samples time a
+ *		single call after evicting the caches.
+ *
+ *	@param	benchmark	: Benchmark to time.
+ *	@param	repetitions	: Number of samples.
+ *	@param	isCold		: Time cache-cold single calls instead of warm batches.
+ *	@param	samples		: Scratch space for `repetitions` samples.
+ *	@return	PrimitiveStatistics	: Statistics of the time per call in nanoseconds.
+ */
+static PrimitiveStatistics	timeBenchmark(const PrimitiveBenchmark *  benchmark, size_t repetitions, bool isCold, double *  samples);
+
+/**
+ *	@brief	qsort() comparison of two doubles.
+ *
+ *	@param	a		: Pointer to the first value.
+ *	@param	b		: Pointer to the second value.
+ *	@return	int		: Negative, zero or positive as `a` is below, equal to or above `b`.
+ */
+static int	compareDouble(const void *  a, const void *  b);
+
+int
+main(int argc, char *  argv[])
+{
+	CommandLineArguments	arguments;
+	size_t			repetitions;
+	double *		samples;
+	static const char *	kRootNames[] = { "exact", "float", "fast" };
+
+	if (getCommandLineArguments(argc, argv, &arguments))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	repetitions = (arguments.common.numberOfMonteCarloIterations > 1) ? arguments.common.numberOfMonteCarloIterations : kPrimitivesBenchmarkConstantDefaultRepetitions;
+	rawDataPath = arguments.rawDataPath;
+	emissivity = arguments.emissivity;
+
+	if (readUint16DataFromCSV(eeData, 0, kMLX90640ConstantEEDataBufferSize, arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (readUint16DataFromCSV(rawDataFrame, 0, kMLX90640ConstantRawFrameBufferSize, rawDataPath) < kMLX90640ConstantRawFrameBufferSize)
+	{
+		fprintf(stderr, "Error in reading sensor raw data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MLX90640_ExtractParameters(eeData, &mlx90640Params))
+	{
+		fprintf(stderr, "Error in extracting parameters from EE\n");
+		exit(EXIT_FAILURE);
+	}
+
+	MLX90640_PrepareFixedPointParameters(&mlx90640Params, emissivity, kMLX90640ConstantTaShift, &fixedPointParams);
+	tr = MLX90640_GetTa(rawDataFrame, &mlx90640Params) - kMLX90640ConstantTaShift;
+
+	for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+	{
+		emissivityMap[i] = emissivity;
+	}
+	for (size_t e = 0; e < kPrimitivesBenchmarkConstantSweepCount; e++)
+	{
+		emissivitySweep[e] = 0.90f + 0.01f * e;
+	}
+
+	samples = calloc(repetitions, sizeof(double));
+	evictionBuffer = calloc(kPrimitivesBenchmarkConstantEvictionBytes, 1);
+	if ((samples == NULL) || (evictionBuffer == NULL))
+	{
+		fprintf(stderr, "Error in allocating benchmark buffers\n");
+		exit(EXIT_FAILURE);
+	}
+
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveReadCSV }, "readUint16DataFromCSV");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveExtractParameters }, "MLX90640_ExtractParameters");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveGetVdd }, "MLX90640_GetVdd");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveGetTa }, "MLX90640_GetTa");
+
+	for (int precision = kMLX90640PrecisionFloat; precision <= kMLX90640PrecisionDouble; precision++)
+	{
+		for (int rootPrecision = kMLX90640RootPrecisionExact; rootPrecision <= kMLX90640RootPrecisionFast; rootPrecision++)
+		{
+			for (int flags = 0; flags < 4; flags++)
+			{
+				char	name[kPrimitivesBenchmarkConstantMaxNameLength];
+
+				snprintf(
+					name,
+					sizeof(name),
+					"CalculateTo %s/%s%s%s",
+					(precision == kMLX90640PrecisionDouble) ? "double" : "float",
+					kRootNames[rootPrecision],
+					(flags & 1) ? " -q" : "",
+					(flags & 2) ? " -m" : "");
+				addBenchmark(
+					(PrimitiveBenchmark) {
+						.primitive = kPrimitiveCalculateTo,
+						.precision = precision,
+						.rootPrecision = rootPrecision,
+						.quantizationError = !(flags & 1),
+						.emissivityMap = (flags & 2),
+					},
+					name);
+			}
+		}
+	}
+
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveCalculateToSweep, .quantizationError = true }, "CalculateToSweep float/exact x10");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveCalculateToFixedPoint }, "CalculateTo fixed");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveFormatOutput }, "format 768 x %f");
+	addBenchmark((PrimitiveBenchmark) { .primitive = kPrimitiveFormatOutputFixed }, "format 768 x formatFixed");
+
+	printf("Repetitions: %zu, times per call in nanoseconds\n", repetitions);
+	printf("%-36s %-5s %8s %12s %12s %12s %12s %8s\n", "primitive", "cache", "batch", "min", "median", "mean", "p99", "rsd %");
+
+	for (size_t b = 0; b < benchmarkCount; b++)
+	{
+		for (int isCold = 0; isCold <= 1; isCold++)
+		{
+			PrimitiveStatistics	statistics = timeBenchmark(&benchmarks[b], repetitions, isCold, samples);
+
+			printf(
+				"%-36s %-5s %8zu %12.1f %12.1f %12.1f %12.1f %8.2f\n",
+				benchmarks[b].name,
+				isCold ? "cold" : "warm",
+				statistics.batch,
+				statistics.minimum,
+				statistics.median,
+				statistics.mean,
+				statistics.p99,
+				statistics.relativeStandardDeviation);
+		}
+	}
+
+	free(samples);
+	free(evictionBuffer);
+
+	return 0;
+}
+
+static void
+addBenchmark(PrimitiveBenchmark benchmark, const char *  name)
+{
+	if (benchmarkCount == kPrimitivesBenchmarkConstantMaxBenchmarks)
+	{
+		fprintf(stderr, "Error: Too many benchmarks\n");
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(benchmark.name, sizeof(benchmark.name), "%s", name);
+	benchmarks[benchmarkCount++] = benchmark;
+}
+
+static void
+runPrimitive(const PrimitiveBenchmark *  benchmark)
+{
+	float		value;
+	size_t		length = 0;
+
+	switch (benchmark->primitive)
+	{
+		case kPrimitiveReadCSV:
+			readUint16DataFromCSV(rawDataFrame, 0, kMLX90640ConstantRawFrameBufferSize, rawDataPath);
+			doNotOptimize((void *)rawDataFrame);
+			break;
+
+		case kPrimitiveExtractParameters:
+			MLX90640_ExtractParameters(eeData, &mlx90640Params);
+			doNotOptimize((void *)&mlx90640Params);
+			break;
+
+		case kPrimitiveGetVdd:
+			value = MLX90640_GetVdd(rawDataFrame, &mlx90640Params);
+			doNotOptimize((void *)&value);
+			break;
+
+		case kPrimitiveGetTa:
+			value = MLX90640_GetTa(rawDataFrame, &mlx90640Params);
+			doNotOptimize((void *)&value);
+			break;
+
+		case kPrimitiveCalculateTo:
+			if (benchmark->precision == kMLX90640PrecisionDouble)
+			{
+				MLX90640_CalculateTo_UTDouble(
+					rawDataFrame,
+					&mlx90640Params,
+					emissivity,
+					benchmark->emissivityMap ? emissivityMap : NULL,
+					tr,
+					mlx90640ToDouble,
+					benchmark->quantizationError,
+					benchmark->rootPrecision);
+				doNotOptimize((void *)mlx90640ToDouble);
+			}
+			else
+			{
+				MLX90640_CalculateTo_UT(
+					rawDataFrame,
+					&mlx90640Params,
+					emissivity,
+					benchmark->emissivityMap ? emissivityMap : NULL,
+					tr,
+					mlx90640To,
+					benchmark->quantizationError,
+					benchmark->rootPrecision);
+				doNotOptimize((void *)mlx90640To);
+			}
+			break;
+
+		case kPrimitiveCalculateToSweep:
+			MLX90640_CalculateToSweep_UT(
+				rawDataFrame,
+				&mlx90640Params,
+				emissivitySweep,
+				kPrimitivesBenchmarkConstantSweepCount,
+				tr,
+				emissivitySweepTable,
+				benchmark->quantizationError,
+				benchmark->rootPrecision);
+			doNotOptimize((void *)emissivitySweepTable);
+			break;
+
+		case kPrimitiveCalculateToFixedPoint:
+			MLX90640_CalculateTo_FixedPoint(rawDataFrame, &fixedPointParams, mlx90640ToCentiKelvin);
+			doNotOptimize((void *)mlx90640ToCentiKelvin);
+			break;
+
+		case kPrimitiveFormatOutput:
+			/*
+			 *	The `-a` text output of one frame, formatted into memory.
+			 */
+			for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+			{
+				length += snprintf(&formatBuffer[length], sizeof(formatBuffer) - length, "%f ", mlx90640To[i]);
+			}
+			doNotOptimize((void *)formatBuffer);
+			break;
+
+		case kPrimitiveFormatOutputFixed:
+			/*
+			 *	The same output with `-f fixed`.
+			 */
+			for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+			{
+				length += formatFixed(&formatBuffer[length], mlx90640To[i], 6);
+				formatBuffer[length++] = ' ';
+			}
+			doNotOptimize((void *)formatBuffer);
+			break;
+	}
+}
+
+static void
+evictCaches(void)
+{
+	for (size_t i = 0; i < kPrimitivesBenchmarkConstantEvictionBytes; i += kMLX90640ConstantCacheLineSize)
+	{
+		evictionBuffer[i]++;
+	}
+	doNotOptimize((void *)evictionBuffer);
+}
+
+static PrimitiveStatistics
+timeBenchmark(const PrimitiveBenchmark *  benchmark, size_t repetitions, bool isCold, double *  samples)
+{
+	PrimitiveStatistics	statistics = { .batch = 1 };
+	uint64_t		start;
+	double			sum = 0;
+	double			sumOfSquares = 0;
+
+	/*
+	 *	Warm up for a fixed time, doubling the batch until one batch is long
+	 *	enough compared to the overhead of reading the clock.
+	 */
+	start = getMonotonicTimeNanoseconds();
+	while (getMonotonicTimeNanoseconds() - start < kPrimitivesBenchmarkConstantWarmUpNanoseconds)
+	{
+		uint64_t	batchStart = getMonotonicTimeNanoseconds();
+
+		for (size_t i = 0; i < statistics.batch; i++)
+		{
+			runPrimitive(benchmark);
+		}
+
+		if (getMonotonicTimeNanoseconds() - batchStart < kPrimitivesBenchmarkConstantMinBatchNanoseconds)
+		{
+			statistics.batch *= 2;
+		}
+	}
+
+	if (isCold)
+	{
+		statistics.batch = 1;
+	}
+
+	for (size_t r = 0; r < repetitions; r++)
+	{
+		if (isCold)
+		{
+			evictCaches();
+		}
+
+		start = getMonotonicTimeNanoseconds();
+		for (size_t i = 0; i < statistics.batch; i++)
+		{
+			runPrimitive(benchmark);
+		}
+		samples[r] = (double)(getMonotonicTimeNanoseconds() - start) / statistics.batch;
+
+		sum += samples[r];
+		sumOfSquares += samples[r] * samples[r];
+	}
+
+	qsort(samples, repetitions, sizeof(double), compareDouble);
+
+	statistics.minimum = samples[0];
+	statistics.median = samples[repetitions / 2];
+	statistics.mean = sum / repetitions;
+	statistics.p99 = samples[(repetitions * 99 + 99) / 100 - 1];
+	statistics.relativeStandardDeviation = 100 * sqrt(fmax(0, sumOfSquares / repetitions - statistics.mean * statistics.mean)) / statistics.mean;
+
+	return statistics;
+}
+
+static int
+compareDouble(const void *  a, const void *  b)
+{
+	double	x = *(const double *)a;
+	double	y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
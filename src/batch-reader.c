@@ -0,0 +1,818 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+/*
+ *	For scandir() d_type, struct statx and syscall().
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "batch-reader.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+/*
+ *	The io_uring backend needs the opcode probe and the open, statx and close
+ *	operations of the Linux 5.6 headers. Elsewhere, only the thread pool is built
+ *	and kBatchReaderBackendIoUring falls back to it.
+ */
+#if defined(IO_URING_OP_SUPPORTED) && defined(STATX_SIZE) && defined(__NR_io_uring_setup)
+#define BATCH_READER_IO_URING	1
+#else
+#define BATCH_READER_IO_URING	0
+#endif
+
+/*
+ *	Operations of a file, in the low bits of the io_uring user data. The
+ *	remaining bits are the slot of the file.
+ */
+typedef enum
+{
+	kBatchReaderOperationOpen	= 0,
+	kBatchReaderOperationStatx	= 1,
+	kBatchReaderOperationRead	= 2,
+	kBatchReaderOperationClose	= 3,
+	kBatchReaderOperationBits	= 2,
+} BatchReaderOperation;
+
+/**
+ *	@brief	scandir() filter of the entries that can be recordings.
+ *
+ *	@param	entry		: Directory entry.
+ *	@return	int		: Non-zero for regular files and entries of unknown type other than "." and "..".
+ */
+static int	isRecordingEntry(const struct dirent *  entry);
+
+/**
+ *	@brief	Allocate the statx buffers of the slots and set up the io_uring instance.
+ *
+ *	@param	reader		: Reader.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ *				  if io_uring is unavailable.
+ */
+static CommonConstantReturnType	setUpIoUring(BatchReader *  reader);
+
+#if BATCH_READER_IO_URING
+/**
+ *	@brief	Create the io_uring instance and check that it supports every operation of the reader.
+ *
+ *	@param	ring		: Ring to set up.
+ *	@param	entries		: Number of submission queue entries.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	setUpRing(BatchReaderRing *  ring, unsigned entries);
+
+/**
+ *	@brief	Queue an operation in the submission queue. It is submitted by the next enterRing().
+ *
+ *	@param	ring		: Ring.
+ *	@param	opcode		: io_uring opcode.
+ *	@param	fd		: File descriptor operated on.
+ *	@param	address		: Path or buffer.
+ *	@param	length		: Mode, mask or length.
+ *	@param	offset		: File offset, or the statx buffer.
+ *	@param	flags		: Open or statx flags.
+ *	@param	userData	: Slot and BatchReaderOperation.
+ */
+static void	queueOperation(BatchReaderRing *  ring, uint8_t opcode, int fd, const void *  address, uint32_t length, uint64_t offset, uint32_t flags, uint64_t userData);
+
+/**
+ *	@brief	Advance a file after the completion of one of its operations.
+ *
+ *	@param	reader		: Reader.
+ *	@param	userData	: Slot and BatchReaderOperation of the operation.
+ *	@param	result		: Result of the operation, a negative errno on failure.
+ */
+static void	handleCompletion(BatchReader *  reader, uint64_t userData, int32_t result);
+#endif
+
+/**
+ *	@brief	Unmap and close the io_uring instance.
+ *
+ *	@param	ring		: Ring.
+ */
+static void	tearDownRing(BatchReaderRing *  ring);
+
+/**
+ *	@brief	Submit the queued operations and wait for completions.
+ *
+ *	@param	ring		: Ring.
+ *	@param	minComplete	: Number of completions to wait for.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	enterRing(BatchReaderRing *  ring, unsigned minComplete);
+
+/**
+ *	@brief	Handle every completion in the completion queue.
+ *
+ *	@param	reader		: Reader.
+ */
+static void	reapCompletions(BatchReader *  reader);
+
+/**
+ *	@brief	Start reading a file into its slot, with io_uring or by waking up the thread pool.
+ *
+ *	@param	reader		: Reader.
+ */
+static void	startNextFile(BatchReader *  reader);
+
+/**
+ *	@brief	Thread of the thread pool backend: read files into their slots until every file was read.
+ *
+ *	@param	argument	: Reader.
+ *	@return			: NULL
+ */
+static void *	readFiles(void *  argument);
+
+/**
+ *	@brief	Read a whole file with blocking system calls.
+ *
+ *	@param	path		: Path of the file.
+ *	@param	file		: Slot to read into.
+ */
+static void	readFile(const char *  path, BatchReaderFile *  file);
+
+/**
+ *	@brief	Grow the buffer of a slot to hold `size` bytes and the spare byte.
+ *
+ *	@param	file		: Slot.
+ *	@param	size		: Size of the file.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	reserveBuffer(BatchReaderFile *  file, size_t size);
+
+/**
+ *	@brief	Wait until the next file has been read.
+ *
+ *	@param	reader		: Reader.
+ *	@return			: Slot of the file.
+ */
+static BatchReaderFile *	acquireFile(BatchReader *  reader);
+
+/**
+ *	@brief	Hand the slot of the file of the last acquireFile() to the next file.
+ *
+ *	@param	reader		: Reader.
+ */
+static void	releaseFile(BatchReader *  reader);
+
+CommonConstantReturnType
+batchReaderOpen(BatchReader *  reader, const char *  directory, FrameReaderFormat format, size_t depth, BatchReaderBackend backend)
+{
+	struct dirent **	entries;
+	int			entryCount;
+
+	*reader = (BatchReader) {
+		.backend	= backend,
+		.format		= format,
+		.depth		= depth,
+		.ring		= { .fd = -1 },
+	};
+
+	if ((depth == 0) || (depth > kBatchReaderConstantMaxDepth))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	entryCount = scandir(directory, &entries, isRecordingEntry, alphasort);
+	if (entryCount < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	reader->paths = calloc(entryCount + 1, sizeof(char *));
+	reader->files = calloc(depth, sizeof(BatchReaderFile));
+	for (size_t i = 0; (reader->files != NULL) && (i < depth); i++)
+	{
+		reader->files[i].fd = -1;
+	}
+
+	for (int i = 0; i < entryCount; i++)
+	{
+		if ((reader->paths != NULL) && (asprintf(&reader->paths[reader->fileCount], "%s/%s", directory, entries[i]->d_name) >= 0))
+		{
+			reader->fileCount++;
+		}
+		free(entries[i]);
+	}
+	free(entries);
+
+	if ((reader->paths == NULL) || (reader->files == NULL) || (reader->fileCount < (size_t)entryCount))
+	{
+		batchReaderClose(reader);
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((reader->backend == kBatchReaderBackendIoUring) && (setUpIoUring(reader) != kCommonConstantReturnTypeSuccess))
+	{
+		reader->backend = kBatchReaderBackendThreadPool;
+	}
+
+	if (reader->backend == kBatchReaderBackendThreadPool)
+	{
+		pthread_mutex_init(&reader->mutex, NULL);
+		pthread_cond_init(&reader->isFileDone, NULL);
+		pthread_cond_init(&reader->isSlotFree, NULL);
+
+		for (; (reader->threadCount < kBatchReaderConstantThreadCount) && (reader->threadCount < depth); reader->threadCount++)
+		{
+			if (pthread_create(&reader->threads[reader->threadCount], NULL, readFiles, reader) != 0)
+			{
+				break;
+			}
+		}
+
+		if (reader->threadCount == 0)
+		{
+			batchReaderClose(reader);
+			return kCommonConstantReturnTypeError;
+		}
+	}
+	else
+	{
+		while ((reader->nextSubmit < reader->fileCount) && (reader->nextSubmit < depth))
+		{
+			startNextFile(reader);
+		}
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+int
+batchReaderRead(BatchReader *  reader, uint16_t *  dest, int maxLength)
+{
+	for (;;)
+	{
+		BatchReaderFile *	file;
+
+		if (reader->current != NULL)
+		{
+			int	ret = frameReaderRead(&reader->frameReader, dest, maxLength);
+
+			if (ret >= 0)
+			{
+				return ret;
+			}
+			releaseFile(reader);
+		}
+
+		if (reader->nextDeliver == reader->fileCount)
+		{
+			return -1;
+		}
+
+		file = acquireFile(reader);
+		if (file->error != 0)
+		{
+			reader->failedFileCount++;
+			releaseFile(reader);
+			continue;
+		}
+
+		reader->byteCount += file->size;
+		frameReaderOpenMemory(&reader->frameReader, file->data, file->size, reader->format);
+		reader->current = file;
+	}
+}
+
+void
+batchReaderClose(BatchReader *  reader)
+{
+	if (reader->threadCount > 0)
+	{
+		pthread_mutex_lock(&reader->mutex);
+		reader->isStopping = true;
+		pthread_cond_broadcast(&reader->isSlotFree);
+		pthread_mutex_unlock(&reader->mutex);
+
+		for (size_t i = 0; i < reader->threadCount; i++)
+		{
+			pthread_join(reader->threads[i], NULL);
+		}
+		pthread_mutex_destroy(&reader->mutex);
+		pthread_cond_destroy(&reader->isFileDone);
+		pthread_cond_destroy(&reader->isSlotFree);
+	}
+
+	if (reader->ring.fd >= 0)
+	{
+		/*
+		 *	The kernel may still write into the buffers of the slots.
+		 */
+		while ((reader->ring.inFlightCount > 0) && (enterRing(&reader->ring, 1) == kCommonConstantReturnTypeSuccess))
+		{
+			reapCompletions(reader);
+		}
+		tearDownRing(&reader->ring);
+	}
+
+	if (reader->files != NULL)
+	{
+		for (size_t i = 0; i < reader->depth; i++)
+		{
+			if (reader->files[i].fd >= 0)
+			{
+				close(reader->files[i].fd);
+			}
+			free(reader->files[i].data);
+		}
+		free(reader->files[0].status);
+		free(reader->files);
+	}
+
+	if (reader->paths != NULL)
+	{
+		for (size_t i = 0; i < reader->fileCount; i++)
+		{
+			free(reader->paths[i]);
+		}
+		free(reader->paths);
+	}
+
+	*reader = (BatchReader) { .ring = { .fd = -1 } };
+}
+
+static int
+isRecordingEntry(const struct dirent *  entry)
+{
+	return (entry->d_type == DT_REG) ||
+		((entry->d_type == DT_UNKNOWN) && (strcmp(entry->d_name, ".") != 0) && (strcmp(entry->d_name, "..") != 0));
+}
+
+#if BATCH_READER_IO_URING
+static CommonConstantReturnType
+setUpIoUring(BatchReader *  reader)
+{
+	struct statx *	status = calloc(reader->depth, sizeof(struct statx));
+
+	if (status == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	A slot can hold the open and statx of a file and the close of the
+	 *	previous file of the slot at the same time.
+	 */
+	if (setUpRing(&reader->ring, 4 * reader->depth) != kCommonConstantReturnTypeSuccess)
+	{
+		free(status);
+		return kCommonConstantReturnTypeError;
+	}
+
+	for (size_t i = 0; i < reader->depth; i++)
+	{
+		reader->files[i].status = &status[i];
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static CommonConstantReturnType
+setUpRing(BatchReaderRing *  ring, unsigned entries)
+{
+	struct io_uring_params	params = { 0 };
+	struct io_uring_probe *	probe;
+	const uint8_t		kOpcodes[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+	bool			isSupported;
+
+	ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->fd < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	Kernels before 5.6 have io_uring but not the open, statx and close
+	 *	operations, and cannot be probed.
+	 */
+	probe = calloc(1, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+	isSupported = (probe != NULL) && (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0);
+	for (size_t i = 0; isSupported && (i < sizeof(kOpcodes)); i++)
+	{
+		isSupported = (kOpcodes[i] <= probe->last_op) && ((probe->ops[kOpcodes[i]].flags & IO_URING_OP_SUPPORTED) != 0);
+	}
+	free(probe);
+
+	ring->entries = params.sq_entries;
+	ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+	if (!isSupported || (ring->sqRing == MAP_FAILED) || (ring->cqRing == MAP_FAILED) || (ring->sqes == MAP_FAILED))
+	{
+		tearDownRing(ring);
+		return kCommonConstantReturnTypeError;
+	}
+
+	ring->sqHead = (_Atomic unsigned *)((uint8_t *)ring->sqRing + params.sq_off.head);
+	ring->sqTail = (_Atomic unsigned *)((uint8_t *)ring->sqRing + params.sq_off.tail);
+	ring->sqMask = (unsigned *)((uint8_t *)ring->sqRing + params.sq_off.ring_mask);
+	ring->sqArray = (unsigned *)((uint8_t *)ring->sqRing + params.sq_off.array);
+	ring->cqHead = (_Atomic unsigned *)((uint8_t *)ring->cqRing + params.cq_off.head);
+	ring->cqTail = (_Atomic unsigned *)((uint8_t *)ring->cqRing + params.cq_off.tail);
+	ring->cqMask = (unsigned *)((uint8_t *)ring->cqRing + params.cq_off.ring_mask);
+	ring->cqes = (uint8_t *)ring->cqRing + params.cq_off.cqes;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static void
+queueOperation(BatchReaderRing *  ring, uint8_t opcode, int fd, const void *  address, uint32_t length, uint64_t offset, uint32_t flags, uint64_t userData)
+{
+	unsigned		tail = atomic_load_explicit(ring->sqTail, memory_order_relaxed);
+	unsigned		index = tail & *ring->sqMask;
+	struct io_uring_sqe *	sqe = &((struct io_uring_sqe *)ring->sqes)[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t)(uintptr_t)address;
+	sqe->len = length;
+	sqe->off = offset;
+	sqe->open_flags = flags;
+	sqe->user_data = userData;
+	ring->sqArray[index] = index;
+
+	/*
+	 *	The entry must be complete before the kernel can see the new tail.
+	 */
+	atomic_store_explicit(ring->sqTail, tail + 1, memory_order_release);
+	ring->pendingCount++;
+	ring->inFlightCount++;
+}
+
+static CommonConstantReturnType
+enterRing(BatchReaderRing *  ring, unsigned minComplete)
+{
+	for (;;)
+	{
+		long	ret = syscall(__NR_io_uring_enter, ring->fd, ring->pendingCount, minComplete, (minComplete > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+		if (ret >= 0)
+		{
+			ring->pendingCount -= ret;
+			return kCommonConstantReturnTypeSuccess;
+		}
+
+		if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY))
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+}
+
+static void
+reapCompletions(BatchReader *  reader)
+{
+	BatchReaderRing *	ring = &reader->ring;
+	unsigned		head = atomic_load_explicit(ring->cqHead, memory_order_relaxed);
+	unsigned		tail = atomic_load_explicit(ring->cqTail, memory_order_acquire);
+
+	for (; head != tail; head++)
+	{
+		struct io_uring_cqe *	cqe = &((struct io_uring_cqe *)ring->cqes)[head & *ring->cqMask];
+
+		ring->inFlightCount--;
+		handleCompletion(reader, cqe->user_data, cqe->res);
+	}
+
+	atomic_store_explicit(ring->cqHead, head, memory_order_release);
+}
+
+static void
+handleCompletion(BatchReader *  reader, uint64_t userData, int32_t result)
+{
+	BatchReaderFile *	file = &reader->files[userData >> kBatchReaderOperationBits];
+	BatchReaderOperation	operation = userData & ((1 << kBatchReaderOperationBits) - 1);
+
+	if (operation == kBatchReaderOperationClose)
+	{
+		return;
+	}
+	file->pendingCount--;
+
+	if (result < 0)
+	{
+		file->error = -result;
+	}
+	else if (operation == kBatchReaderOperationOpen)
+	{
+		file->fd = result;
+	}
+	else if (operation == kBatchReaderOperationRead)
+	{
+		file->offset += result;
+	}
+
+	if (file->pendingCount > 0)
+	{
+		return;
+	}
+
+	/*
+	 *	After the open and statx, read the whole file. Reads can be short,
+	 *	and a file that shrank ends at its first empty read.
+	 */
+	if ((file->error == 0) && (operation != kBatchReaderOperationRead) && (reserveBuffer(file, file->status->stx_size) != kCommonConstantReturnTypeSuccess))
+	{
+		file->error = ENOMEM;
+	}
+
+	if ((file->error == 0) && (file->offset < file->status->stx_size) && ((operation != kBatchReaderOperationRead) || (result > 0)))
+	{
+		size_t	length = file->status->stx_size - file->offset;
+
+		queueOperation(
+			&reader->ring,
+			IORING_OP_READ,
+			file->fd,
+			&file->data[file->offset],
+			(length < (1u << 30)) ? length : (1u << 30),
+			file->offset,
+			0,
+			((uint64_t)(file - reader->files) << kBatchReaderOperationBits) | kBatchReaderOperationRead);
+		file->pendingCount++;
+		return;
+	}
+
+	if (file->fd >= 0)
+	{
+		queueOperation(&reader->ring, IORING_OP_CLOSE, file->fd, NULL, 0, 0, 0, kBatchReaderOperationClose);
+		file->fd = -1;
+	}
+	file->size = file->offset;
+	file->isDone = true;
+}
+
+static void
+startNextFile(BatchReader *  reader)
+{
+	size_t			index = reader->nextSubmit++;
+	size_t			slot = index % reader->depth;
+	BatchReaderFile *	file = &reader->files[slot];
+	uint64_t		userData = (uint64_t)slot << kBatchReaderOperationBits;
+
+	file->size = 0;
+	file->offset = 0;
+	file->error = 0;
+	file->pendingCount = 2;
+
+	queueOperation(&reader->ring, IORING_OP_OPENAT, AT_FDCWD, reader->paths[index], 0, 0, O_RDONLY | O_CLOEXEC, userData | kBatchReaderOperationOpen);
+	queueOperation(
+		&reader->ring,
+		IORING_OP_STATX,
+		AT_FDCWD,
+		reader->paths[index],
+		STATX_SIZE,
+		(uint64_t)(uintptr_t)file->status,
+		0,
+		userData | kBatchReaderOperationStatx);
+}
+#else
+static CommonConstantReturnType
+setUpIoUring(BatchReader *  reader)
+{
+	return kCommonConstantReturnTypeError;
+}
+
+static CommonConstantReturnType
+enterRing(BatchReaderRing *  ring, unsigned minComplete)
+{
+	return kCommonConstantReturnTypeError;
+}
+
+static void
+reapCompletions(BatchReader *  reader)
+{
+}
+
+static void
+startNextFile(BatchReader *  reader)
+{
+}
+#endif
+
+static void
+tearDownRing(BatchReaderRing *  ring)
+{
+	if ((ring->sqRing != NULL) && (ring->sqRing != MAP_FAILED))
+	{
+		munmap(ring->sqRing, ring->sqRingSize);
+	}
+	if ((ring->cqRing != NULL) && (ring->cqRing != MAP_FAILED))
+	{
+		munmap(ring->cqRing, ring->cqRingSize);
+	}
+	if ((ring->sqes != NULL) && (ring->sqes != MAP_FAILED))
+	{
+		munmap(ring->sqes, ring->sqesSize);
+	}
+	close(ring->fd);
+
+	*ring = (BatchReaderRing) { .fd = -1 };
+}
+
+static void *
+readFiles(void *  argument)
+{
+	BatchReader *	reader = argument;
+
+	pthread_mutex_lock(&reader->mutex);
+	for (;;)
+	{
+		size_t			index;
+		BatchReaderFile *	file;
+
+		while (!reader->isStopping && (reader->nextSubmit < reader->fileCount) && (reader->nextSubmit >= reader->nextDeliver + reader->depth))
+		{
+			pthread_cond_wait(&reader->isSlotFree, &reader->mutex);
+		}
+
+		if (reader->isStopping || (reader->nextSubmit == reader->fileCount))
+		{
+			break;
+		}
+		index = reader->nextSubmit++;
+		file = &reader->files[index % reader->depth];
+		pthread_mutex_unlock(&reader->mutex);
+
+		readFile(reader->paths[index], file);
+
+		pthread_mutex_lock(&reader->mutex);
+		file->isDone = true;
+		pthread_cond_signal(&reader->isFileDone);
+	}
+	pthread_mutex_unlock(&reader->mutex);
+
+	return NULL;
+}
+
+static void
+readFile(const char *  path, BatchReaderFile *  file)
+{
+	int		fd = open(path, O_RDONLY | O_CLOEXEC);
+	struct stat	status;
+
+	file->size = 0;
+	file->offset = 0;
+	file->error = 0;
+
+	if (fd < 0)
+	{
+		file->error = errno;
+		return;
+	}
+
+	if (fstat(fd, &status) != 0)
+	{
+		file->error = errno;
+	}
+	else if (reserveBuffer(file, status.st_size) != kCommonConstantReturnTypeSuccess)
+	{
+		file->error = ENOMEM;
+	}
+
+	while ((file->error == 0) && (file->offset < (size_t)status.st_size))
+	{
+		ssize_t	received = read(fd, &file->data[file->offset], status.st_size - file->offset);
+
+		if (received < 0)
+		{
+			if (errno != EINTR)
+			{
+				file->error = errno;
+			}
+			continue;
+		}
+
+		if (received == 0)
+		{
+			break;
+		}
+		file->offset += received;
+	}
+	file->size = file->offset;
+
+	close(fd);
+}
+
+static CommonConstantReturnType
+reserveBuffer(BatchReaderFile *  file, size_t size)
+{
+	char *	data;
+
+	if (size + 1 <= file->capacity)
+	{
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	data = realloc(file->data, size + 1);
+	if (data == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+	file->data = data;
+	file->capacity = size + 1;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static BatchReaderFile *
+acquireFile(BatchReader *  reader)
+{
+	BatchReaderFile *	file = &reader->files[reader->nextDeliver % reader->depth];
+
+	if (reader->backend == kBatchReaderBackendThreadPool)
+	{
+		pthread_mutex_lock(&reader->mutex);
+		while (!file->isDone)
+		{
+			pthread_cond_wait(&reader->isFileDone, &reader->mutex);
+		}
+		pthread_mutex_unlock(&reader->mutex);
+
+		return file;
+	}
+
+	/*
+	 *	Completions are handled without a system call. One io_uring_enter(2)
+	 *	submits everything queued since the last one, e.g., the reads of files
+	 *	whose open completed, and waits only if this file is not complete.
+	 */
+	reapCompletions(reader);
+	while (!file->isDone || (reader->ring.pendingCount > 0))
+	{
+		if (enterRing(&reader->ring, file->isDone ? 0 : 1) != kCommonConstantReturnTypeSuccess)
+		{
+			file->error = (file->error != 0) ? file->error : errno;
+			file->isDone = true;
+			break;
+		}
+		reapCompletions(reader);
+	}
+
+	return file;
+}
+
+static void
+releaseFile(BatchReader *  reader)
+{
+	BatchReaderFile *	file = &reader->files[reader->nextDeliver % reader->depth];
+
+	reader->current = NULL;
+
+	if (reader->backend == kBatchReaderBackendThreadPool)
+	{
+		pthread_mutex_lock(&reader->mutex);
+		file->isDone = false;
+		reader->nextDeliver++;
+		pthread_cond_broadcast(&reader->isSlotFree);
+		pthread_mutex_unlock(&reader->mutex);
+
+		return;
+	}
+
+	file->isDone = false;
+	reader->nextDeliver++;
+	if (reader->nextSubmit < reader->fileCount)
+	{
+		startNextFile(reader);
+	}
+}
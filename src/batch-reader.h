@@ -0,0 +1,148 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "common.h"
+#include "frame-reader.h"
+
+/*
+ *	Ways of reading the files of a directory.
+ */
+typedef enum
+{
+	kBatchReaderBackendIoUring	= 0,	/* io_uring, falling back to the thread pool when unavailable */
+	kBatchReaderBackendThreadPool	= 1,	/* Threads reading one file each with blocking system calls */
+} BatchReaderBackend;
+
+typedef enum
+{
+	kBatchReaderConstantDefaultDepth	= 64,	/* Files read ahead of the consumer */
+	kBatchReaderConstantMaxDepth		= 1024,
+	kBatchReaderConstantThreadCount		= 8,	/* Threads of the thread pool backend */
+} BatchReaderConstant;
+
+/*
+ *	A file of the window read ahead of the consumer. File i of the directory
+ *	is read into slot i modulo the depth.
+ */
+typedef struct BatchReaderFile
+{
+	char *		data;		/* `size` bytes and a spare byte, see frameReaderOpenMemory() */
+	size_t		size;
+	size_t		offset;		/* Bytes read so far */
+	size_t		capacity;
+	int		error;		/* errno of a failed open or read, else 0 */
+	bool		isDone;
+	int		fd;
+	int		pendingCount;	/* io_uring operations in flight */
+	struct statx *	status;		/* Size of the file, from an io_uring statx (io_uring backend only) */
+} BatchReaderFile;
+
+/*
+ *	Submission and completion queues of an io_uring instance, mapped from
+ *	the kernel.
+ */
+typedef struct BatchReaderRing
+{
+	int		fd;
+	unsigned	entries;
+	unsigned	pendingCount;	/* Submission queue entries not yet passed to io_uring_enter(2) */
+	size_t		inFlightCount;	/* Operations submitted or pending and not yet completed */
+	_Atomic unsigned *	sqHead;
+	_Atomic unsigned *	sqTail;
+	unsigned *	sqMask;
+	unsigned *	sqArray;
+	_Atomic unsigned *	cqHead;
+	_Atomic unsigned *	cqTail;
+	unsigned *	cqMask;
+	void *		sqes;
+	void *		cqes;
+	void *		sqRing;
+	size_t		sqRingSize;
+	void *		cqRing;
+	size_t		cqRingSize;
+	size_t		sqesSize;
+} BatchReaderRing;
+
+/*
+ *	Reader of the raw frames of every regular file of a directory, in file
+ *	name order, keeping the reads of up to `depth` files in flight ahead of
+ *	the file whose frames are being parsed.
+ */
+typedef struct BatchReader
+{
+	BatchReaderBackend	backend;
+	FrameReaderFormat	format;
+	char **			paths;
+	size_t			fileCount;
+	size_t			depth;
+	BatchReaderFile *	files;
+	size_t			nextSubmit;	/* Next file to start reading */
+	size_t			nextDeliver;	/* Next file to hand to the consumer */
+	BatchReaderFile *	current;
+	FrameReader		frameReader;
+	size_t			failedFileCount;
+	size_t			byteCount;
+	BatchReaderRing		ring;
+	pthread_t		threads[kBatchReaderConstantThreadCount];
+	size_t			threadCount;
+	bool			isStopping;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		isFileDone;
+	pthread_cond_t		isSlotFree;
+} BatchReader;
+
+/**
+ *	@brief	List the regular files of a directory and start reading the first `depth` of them.
+ *
+ *	@param	reader		: Reader to set up.
+ *	@param	directory	: Directory of recordings.
+ *	@param	format		: Encoding of the recordings.
+ *	@param	depth		: Number of files read ahead.
+ *	@param	backend		: Requested backend. `reader->backend` is the backend in use.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	batchReaderOpen(BatchReader *  reader, const char *  directory, FrameReaderFormat format, size_t depth, BatchReaderBackend backend);
+
+/**
+ *	@brief	Read the next frame, continuing with the next file at the end of a file. Files that cannot be
+ *		read are skipped and counted in `failedFileCount`.
+ *
+ *	@param	reader		: Reader.
+ *	@param	dest		: Destination of the words.
+ *	@param	maxLength	: Maximum number of words.
+ *	@return	int		: As frameReaderRead(), -1 after the last frame of the last file.
+ */
+int	batchReaderRead(BatchReader *  reader, uint16_t *  dest, int maxLength);
+
+/**
+ *	@brief	Wait for the reads in flight and release the reader.
+ *
+ *	@param	reader		: Reader.
+ */
+void	batchReaderClose(BatchReader *  reader);
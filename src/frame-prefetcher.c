@@ -0,0 +1,194 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frame-prefetcher.h"
+#include "trace.h"
+
+/**
+ *	@brief	Reader thread: fill free buffers until the input ends or the prefetcher is stopped.
+ *
+ *	@param	argument	: Prefetcher.
+ *	@return			: NULL
+ */
+static void *	readFrames(void *  argument);
+
+CommonConstantReturnType
+framePrefetcherStart(FramePrefetcher *  prefetcher, FrameReader *  reader, size_t frameLength, size_t depth)
+{
+	*prefetcher = (FramePrefetcher) {
+		.reader		= reader,
+		.frameLength	= frameLength,
+		.depth		= depth,
+		.frames		= calloc(depth * frameLength, sizeof(uint16_t)),
+		.lengths	= calloc(depth, sizeof(int)),
+	};
+
+	if ((depth == 0) || (prefetcher->frames == NULL) || (prefetcher->lengths == NULL))
+	{
+		free(prefetcher->frames);
+		free(prefetcher->lengths);
+		return kCommonConstantReturnTypeError;
+	}
+
+	pthread_mutex_init(&prefetcher->mutex, NULL);
+	pthread_cond_init(&prefetcher->isNotEmpty, NULL);
+	pthread_cond_init(&prefetcher->isNotFull, NULL);
+
+	if (pthread_create(&prefetcher->thread, NULL, readFrames, prefetcher) != 0)
+	{
+		pthread_mutex_destroy(&prefetcher->mutex);
+		pthread_cond_destroy(&prefetcher->isNotEmpty);
+		pthread_cond_destroy(&prefetcher->isNotFull);
+		free(prefetcher->frames);
+		free(prefetcher->lengths);
+		return kCommonConstantReturnTypeError;
+	}
+	prefetcher->isRunning = true;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+uint16_t *
+framePrefetcherAcquire(FramePrefetcher *  prefetcher, int *  length)
+{
+	size_t	slot;
+
+	pthread_mutex_lock(&prefetcher->mutex);
+	while ((prefetcher->tail == prefetcher->head) && !prefetcher->isEnded)
+	{
+		pthread_cond_wait(&prefetcher->isNotEmpty, &prefetcher->mutex);
+	}
+
+	if (prefetcher->tail == prefetcher->head)
+	{
+		pthread_mutex_unlock(&prefetcher->mutex);
+		*length = -1;
+		return NULL;
+	}
+	slot = prefetcher->tail % prefetcher->depth;
+	pthread_mutex_unlock(&prefetcher->mutex);
+
+	*length = prefetcher->lengths[slot];
+
+	return &prefetcher->frames[slot * prefetcher->frameLength];
+}
+
+void
+framePrefetcherRelease(FramePrefetcher *  prefetcher)
+{
+	pthread_mutex_lock(&prefetcher->mutex);
+	prefetcher->tail++;
+	pthread_cond_signal(&prefetcher->isNotFull);
+	pthread_mutex_unlock(&prefetcher->mutex);
+}
+
+size_t
+framePrefetcherGetCount(FramePrefetcher *  prefetcher)
+{
+	size_t	count;
+
+	pthread_mutex_lock(&prefetcher->mutex);
+	count = prefetcher->head - prefetcher->tail;
+	pthread_mutex_unlock(&prefetcher->mutex);
+
+	return count;
+}
+
+void
+framePrefetcherStop(FramePrefetcher *  prefetcher)
+{
+	if (!prefetcher->isRunning)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&prefetcher->mutex);
+	prefetcher->isStopping = true;
+	pthread_cond_signal(&prefetcher->isNotFull);
+	pthread_mutex_unlock(&prefetcher->mutex);
+	pthread_join(prefetcher->thread, NULL);
+
+	pthread_mutex_destroy(&prefetcher->mutex);
+	pthread_cond_destroy(&prefetcher->isNotEmpty);
+	pthread_cond_destroy(&prefetcher->isNotFull);
+	free(prefetcher->frames);
+	free(prefetcher->lengths);
+	*prefetcher = (FramePrefetcher) { 0 };
+}
+
+static void *
+readFrames(void *  argument)
+{
+	FramePrefetcher *	prefetcher = argument;
+
+	for (size_t frameIndex = 0;; frameIndex++)
+	{
+		size_t		slot;
+		int		length;
+		uint64_t	traceStageBegin;
+
+		pthread_mutex_lock(&prefetcher->mutex);
+		while ((prefetcher->head - prefetcher->tail == prefetcher->depth) && !prefetcher->isStopping)
+		{
+			pthread_cond_wait(&prefetcher->isNotFull, &prefetcher->mutex);
+		}
+
+		if (prefetcher->isStopping)
+		{
+			pthread_mutex_unlock(&prefetcher->mutex);
+			break;
+		}
+		slot = prefetcher->head % prefetcher->depth;
+		pthread_mutex_unlock(&prefetcher->mutex);
+
+		/*
+		 *	The buffer is not visible to the consumer until head is
+		 *	incremented, so it is filled without holding the lock.
+		 */
+		traceStageBegin = traceBegin();
+		length = frameReaderRead(prefetcher->reader, &prefetcher->frames[slot * prefetcher->frameLength], (int) prefetcher->frameLength);
+		traceEnd("frameReaderRead", traceStageBegin, frameIndex);
+
+		pthread_mutex_lock(&prefetcher->mutex);
+		prefetcher->lengths[slot] = length;
+		if (length < 0)
+		{
+			prefetcher->isEnded = true;
+		}
+		else
+		{
+			prefetcher->head++;
+		}
+		pthread_cond_signal(&prefetcher->isNotEmpty);
+		pthread_mutex_unlock(&prefetcher->mutex);
+
+		if (length < 0)
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
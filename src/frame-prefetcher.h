@@ -0,0 +1,95 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "common.h"
+#include "frame-reader.h"
+
+/*
+ *	Pool of `depth` frame buffers that a reader thread fills with the next
+ *	frames of a FrameReader while the consumer converts the current one.
+ *	Buffers are handed to the consumer in place and returned in order.
+ */
+typedef struct FramePrefetcher
+{
+	FrameReader *	reader;
+	size_t		frameLength;
+	size_t		depth;
+	uint16_t *	frames;
+	int *		lengths;
+	size_t		head;		/* Buffers filled by the reader thread */
+	size_t		tail;		/* Buffers released by the consumer */
+	bool		isEnded;
+	bool		isStopping;
+	bool		isRunning;
+	pthread_t	thread;
+	pthread_mutex_t	mutex;
+	pthread_cond_t	isNotEmpty;
+	pthread_cond_t	isNotFull;
+} FramePrefetcher;
+
+/**
+ *	@brief	Allocate the buffers and start the reader thread.
+ *
+ *	@param	prefetcher	: Prefetcher to set up.
+ *	@param	reader		: Open reader, only used by the reader thread until framePrefetcherStop().
+ *	@param	frameLength	: Maximum number of words of a frame.
+ *	@param	depth		: Number of buffers, at least 2 to read while a frame is converted.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	framePrefetcherStart(FramePrefetcher *  prefetcher, FrameReader *  reader, size_t frameLength, size_t depth);
+
+/**
+ *	@brief	Wait for the next frame.
+ *
+ *	@param	prefetcher	: Prefetcher.
+ *	@param	length		: Number of words of the frame as returned by frameReaderRead(), or -1 at the end of the input.
+ *	@return			: Frame, valid until framePrefetcherRelease(), or NULL at the end of the input.
+ */
+uint16_t *	framePrefetcherAcquire(FramePrefetcher *  prefetcher, int *  length);
+
+/**
+ *	@brief	Return the frame of the last framePrefetcherAcquire() to the reader thread.
+ *
+ *	@param	prefetcher	: Prefetcher.
+ */
+void	framePrefetcherRelease(FramePrefetcher *  prefetcher);
+
+/**
+ *	@brief	Get the number of frames read ahead and not yet released.
+ *
+ *	@param	prefetcher	: Prefetcher.
+ *	@return	size_t		: Number of frames.
+ */
+size_t	framePrefetcherGetCount(FramePrefetcher *  prefetcher);
+
+/**
+ *	@brief	Stop the reader thread and release the buffers. Does nothing if the prefetcher is not running.
+ *
+ *	@param	prefetcher	: Prefetcher.
+ */
+void	framePrefetcherStop(FramePrefetcher *  prefetcher);
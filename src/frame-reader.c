@@ -0,0 +1,266 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "frame-reader.h"
+
+_Static_assert((int)kFrameReaderConstantBufferSize >= (int)kCommonConstantMaxCharsPerLine, "A CSV line must fit into the buffer");
+
+/**
+ *	@brief	Move the unread data to the start of the buffer and read more with one read(2).
+ *
+ *	@param	reader		: Reader.
+ *	@return	bool		: false at the end of the input or on errors.
+ */
+static bool	fillBuffer(FrameReader *  reader);
+
+/**
+ *	@brief	Ask the kernel to read the next window of a file ahead once the reader has consumed half of the previous one.
+ *
+ *	@param	reader	: Reader of a regular file.
+ */
+static void	adviseReadahead(FrameReader *  reader);
+
+CommonConstantReturnType
+frameReaderOpen(FrameReader *  reader, const char *  path, FrameReaderFormat format)
+{
+	struct stat	status;
+
+	*reader = (FrameReader) {
+		.fd		= (strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC),
+		.format		= format,
+		.buffer		= malloc(kFrameReaderConstantBufferSize + 1),
+	};
+
+	if ((reader->fd < 0) || (reader->buffer == NULL) || (fstat(reader->fd, &status) != 0))
+	{
+		frameReaderClose(reader);
+		return kCommonConstantReturnTypeError;
+	}
+	reader->isStream = !S_ISREG(status.st_mode);
+
+	/*
+	 *	Recordings are read front to back exactly once per pass.
+	 */
+	if (!reader->isStream)
+	{
+		posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+		adviseReadahead(reader);
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+void
+frameReaderOpenMemory(FrameReader *  reader, char *  data, size_t size, FrameReaderFormat format)
+{
+	*reader = (FrameReader) {
+		.fd		= -1,
+		.format		= format,
+		.isEndOfFile	= true,
+		.isMemory	= true,
+		.buffer		= data,
+		.end		= size,
+	};
+}
+
+void
+frameReaderWait(FrameReader *  reader)
+{
+	if (reader->start == reader->end)
+	{
+		fillBuffer(reader);
+	}
+}
+
+int
+frameReaderRead(FrameReader *  reader, uint16_t *  dest, int maxLength)
+{
+	int	index = 0;
+
+	if (reader->format == kFrameReaderFormatBinary)
+	{
+		size_t	size = (size_t)maxLength * sizeof(uint16_t);
+
+		while ((reader->end - reader->start < size) && fillBuffer(reader));
+
+		for (; (index < maxLength) && (reader->end - reader->start >= sizeof(uint16_t)); index++)
+		{
+			const uint8_t *	bytes = (const uint8_t *)&reader->buffer[reader->start];
+
+			dest[index] = bytes[0] | (bytes[1] << 8);
+			reader->start += sizeof(uint16_t);
+		}
+
+		/*
+		 *	An odd trailing byte cannot start another frame.
+		 */
+		if (index < maxLength)
+		{
+			reader->start = reader->end;
+		}
+
+		return (index == 0) ? -1 : index;
+	}
+
+	for (;;)
+	{
+		char *	line = &reader->buffer[reader->start];
+		char *	newline = memchr(line, '\n', reader->end - reader->start);
+		size_t	length = (newline != NULL) ? (size_t)(newline - line) + 1 : reader->end - reader->start;
+		char	saved;
+		char *	state;
+
+		/*
+		 *	Like fgets(), take at most kCommonConstantMaxCharsPerLine - 1
+		 *	characters, and otherwise read until the line is complete or the
+		 *	input ends.
+		 */
+		if (length >= kCommonConstantMaxCharsPerLine - 1)
+		{
+			length = kCommonConstantMaxCharsPerLine - 1;
+		}
+		else if ((newline == NULL) && fillBuffer(reader))
+		{
+			continue;
+		}
+
+		if (length == 0)
+		{
+			return -1;
+		}
+
+		/*
+		 *	The line is tokenized in place as readUint16DataFromCSV() does. The
+		 *	buffer has a spare byte, so the character after the line can be
+		 *	overwritten and restored.
+		 */
+		saved = line[length];
+		line[length] = '\0';
+		for (char *  token = strtok_r(line, ",", &state); (token != NULL) && (index < maxLength); token = strtok_r(NULL, ",", &state))
+		{
+			dest[index++] = (uint16_t)strtoul(token, NULL, 10);
+		}
+		line[length] = saved;
+		reader->start += length;
+
+		return index;
+	}
+}
+
+CommonConstantReturnType
+frameReaderRewind(FrameReader *  reader)
+{
+	if (reader->isMemory)
+	{
+		reader->start = 0;
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	if (reader->isStream || (lseek(reader->fd, 0, SEEK_SET) != 0))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	reader->start = 0;
+	reader->end = 0;
+	reader->isEndOfFile = false;
+	reader->offset = 0;
+	reader->readaheadEnd = 0;
+	adviseReadahead(reader);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+void
+frameReaderClose(FrameReader *  reader)
+{
+	if ((reader->fd >= 0) && (reader->fd != STDIN_FILENO))
+	{
+		close(reader->fd);
+	}
+
+	if (!reader->isMemory)
+	{
+		free(reader->buffer);
+	}
+
+	*reader = (FrameReader) { .fd = -1 };
+}
+
+static bool
+fillBuffer(FrameReader *  reader)
+{
+	ssize_t	received;
+
+	if (reader->isEndOfFile)
+	{
+		return false;
+	}
+
+	memmove(reader->buffer, &reader->buffer[reader->start], reader->end - reader->start);
+	reader->end -= reader->start;
+	reader->start = 0;
+
+	if (reader->end == kFrameReaderConstantBufferSize)
+	{
+		return false;
+	}
+
+	do
+	{
+		received = read(reader->fd, &reader->buffer[reader->end], kFrameReaderConstantBufferSize - reader->end);
+	} while ((received < 0) && (errno == EINTR));
+
+	if (received <= 0)
+	{
+		reader->isEndOfFile = true;
+		return false;
+	}
+	reader->end += received;
+
+	if (!reader->isStream)
+	{
+		reader->offset += received;
+		adviseReadahead(reader);
+	}
+
+	return true;
+}
+
+static void
+adviseReadahead(FrameReader *  reader)
+{
+	if (reader->offset + kFrameReaderConstantReadaheadSize / 2 < reader->readaheadEnd)
+	{
+		return;
+	}
+
+	posix_fadvise(reader->fd, reader->readaheadEnd, kFrameReaderConstantReadaheadSize, POSIX_FADV_WILLNEED);
+	reader->readaheadEnd += kFrameReaderConstantReadaheadSize;
+}
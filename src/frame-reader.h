@@ -0,0 +1,117 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include "common.h"
+
+/*
+ *	Encodings of raw frame recordings.
+ */
+typedef enum
+{
+	kFrameReaderFormatCSV		= 0,	/* One frame per line, comma-separated decimal words */
+	kFrameReaderFormatBinary	= 1,	/* kMLX90640ConstantRawFrameBufferSize little-endian uint16 per frame */
+} FrameReaderFormat;
+
+typedef enum
+{
+	kFrameReaderConstantBufferSize	= 1 << 16,
+	kFrameReaderConstantReadaheadSize	= 1 << 20,	/* Bytes of a file the kernel is asked to read ahead */
+} FrameReaderConstant;
+
+/*
+ *	Sequential reader of raw frames from a file, a pipe or stdin, through a
+ *	fixed-size buffer filled with read(2).
+ */
+typedef struct FrameReader
+{
+	int			fd;
+	FrameReaderFormat	format;
+	bool			isStream;
+	bool			isEndOfFile;
+	bool			isMemory;	/* Reads a caller-owned buffer instead of fd */
+	char *			buffer;
+	size_t			start;
+	size_t			end;
+	off_t			offset;		/* Bytes of a file read so far */
+	off_t			readaheadEnd;	/* End of the bytes the kernel was asked to read ahead */
+} FrameReader;
+
+/**
+ *	@brief	Open a recording of raw frames.
+ *
+ *	@param	reader		: Reader to set up.
+ *	@param	path		: Path of the recording, or "-" for stdin.
+ *	@param	format		: Encoding of the recording.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	frameReaderOpen(FrameReader *  reader, const char *  path, FrameReaderFormat format);
+
+/**
+ *	@brief	Read the raw frames of a recording that is already in memory, e.g., read by a BatchReader.
+ *
+ *	@param	reader		: Reader to set up.
+ *	@param	data		: Recording, followed by one spare byte that is temporarily overwritten while parsing CSV.
+ *				  It remains owned by the caller and must outlive the reader.
+ *	@param	size		: Size of the recording in bytes, without the spare byte.
+ *	@param	format		: Encoding of the recording.
+ */
+void	frameReaderOpenMemory(FrameReader *  reader, char *  data, size_t size, FrameReaderFormat format);
+
+/**
+ *	@brief	Wait until data of the next frame has arrived or the input has ended, so that callers can
+ *		tell waiting for a producer apart from reading the frame.
+ *
+ *	@param	reader		: Reader.
+ */
+void	frameReaderWait(FrameReader *  reader);
+
+/**
+ *	@brief	Read the next frame. Like readUint16DataFromCSV(), a CSV line is cut after
+ *		kCommonConstantMaxCharsPerLine - 1 characters and parsed up to `maxLength` words.
+ *
+ *	@param	reader		: Reader.
+ *	@param	dest		: Destination of the words.
+ *	@param	maxLength	: Maximum number of words.
+ *	@return	int		: Number of words read, fewer than `maxLength` for an incomplete frame, or -1 at the end of the input.
+ */
+int	frameReaderRead(FrameReader *  reader, uint16_t *  dest, int maxLength);
+
+/**
+ *	@brief	Restart reading from the first frame.
+ *
+ *	@param	reader		: Reader.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, `kCommonConstantReturnTypeError` for pipes and stdin.
+ */
+CommonConstantReturnType	frameReaderRewind(FrameReader *  reader);
+
+/**
+ *	@brief	Close the recording and release the buffer.
+ *
+ *	@param	reader		: Reader.
+ */
+void	frameReaderClose(FrameReader *  reader);
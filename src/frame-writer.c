@@ -0,0 +1,405 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+#include "frame-writer.h"
+
+/**
+ *	@brief	Write all bytes with write(2), retrying partial and interrupted writes.
+ *
+ *	@param	fd		: File descriptor.
+ *	@param	data		: Bytes.
+ *	@param	size		: Number of bytes.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	writeAll(int fd, const char *  data, size_t size);
+
+static const uint64_t	kPowersOfTen[kFrameWriterConstantMaxDecimals + 1] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+size_t
+formatFixed(char *  dest, float value, unsigned int decimals)
+{
+	uint32_t	bits;
+	uint32_t	exponentBits;
+	uint64_t	mantissa;
+	int		exponent;
+	uint64_t	scaled;
+	uint64_t	fixed;
+	uint64_t	integerPart;
+	char		digits[20];
+	size_t		digitCount = 0;
+	size_t		length = 0;
+
+	memcpy(&bits, &value, sizeof(bits));
+	exponentBits = (bits >> 23) & 0xFF;
+	mantissa = bits & 0x7FFFFF;
+
+	if (exponentBits == 0xFF)
+	{
+		return snprintf(dest, kFrameWriterConstantMaxValueLength, "%.*f", decimals, value);
+	}
+
+	if (exponentBits == 0)
+	{
+		exponent = -149;
+	}
+	else
+	{
+		mantissa |= 1 << 23;
+		exponent = (int)exponentBits - 150;
+	}
+
+	/*
+	 *	The value is mantissa * 2^exponent exactly, so the value scaled by
+	 *	10^decimals is (mantissa * 10^decimals) * 2^exponent, with the first
+	 *	factor below 2^54. Shifting it right and rounding the remainder to
+	 *	nearest, ties to even, rounds exactly like printf().
+	 */
+	scaled = mantissa * kPowersOfTen[decimals];
+	if (exponent >= 0)
+	{
+		if (exponent > 9)
+		{
+			return snprintf(dest, kFrameWriterConstantMaxValueLength, "%.*f", decimals, value);
+		}
+		fixed = scaled << exponent;
+	}
+	else if (-exponent >= 64)
+	{
+		fixed = 0;
+	}
+	else
+	{
+		uint64_t	remainder = scaled & ((UINT64_C(1) << -exponent) - 1);
+		uint64_t	half = UINT64_C(1) << (-exponent - 1);
+
+		fixed = scaled >> -exponent;
+		if ((remainder > half) || ((remainder == half) && ((fixed & 1) != 0)))
+		{
+			fixed++;
+		}
+	}
+
+	if ((bits >> 31) != 0)
+	{
+		dest[length++] = '-';
+	}
+
+	integerPart = fixed / kPowersOfTen[decimals];
+	do
+	{
+		digits[digitCount++] = '0' + (integerPart % 10);
+		integerPart /= 10;
+	} while (integerPart != 0);
+
+	while (digitCount > 0)
+	{
+		dest[length++] = digits[--digitCount];
+	}
+
+	if (decimals > 0)
+	{
+		uint64_t	fraction = fixed % kPowersOfTen[decimals];
+
+		dest[length++] = '.';
+		for (unsigned int i = decimals; i > 0; i--)
+		{
+			dest[length + i - 1] = '0' + (fraction % 10);
+			fraction /= 10;
+		}
+		length += decimals;
+	}
+
+	return length;
+}
+
+CommonConstantReturnType
+frameWriterInit(FrameWriter *  writer, FILE *  file, size_t capacity)
+{
+	*writer = (FrameWriter) {
+		.file		= file,
+		.buffer		= malloc(capacity),
+		.length		= 0,
+		.capacity	= capacity,
+		.hasFailed	= false,
+	};
+
+	return ((writer->buffer != NULL) && (capacity >= kFrameWriterConstantMaxValueLength))
+		? kCommonConstantReturnTypeSuccess
+		: kCommonConstantReturnTypeError;
+}
+
+void
+frameWriterAppendString(FrameWriter *  writer, const char *  string)
+{
+	frameWriterAppendBytes(writer, string, strlen(string));
+}
+
+void
+frameWriterAppendBytes(FrameWriter *  writer, const void *  data, size_t size)
+{
+	if (writer->length + size > writer->capacity)
+	{
+		frameWriterFlush(writer);
+	}
+
+	/*
+	 *	Data larger than the buffer bypasses it.
+	 */
+	if (size > writer->capacity)
+	{
+		writer->hasFailed |= (writeAll(fileno(writer->file), data, size) != kCommonConstantReturnTypeSuccess);
+		return;
+	}
+
+	memcpy(&writer->buffer[writer->length], data, size);
+	writer->length += size;
+}
+
+void
+frameWriterAppendUint16(FrameWriter *  writer, uint16_t value)
+{
+	uint8_t	bytes[2] = { value & 0xFF, value >> 8 };
+
+	frameWriterAppendBytes(writer, bytes, sizeof(bytes));
+}
+
+void
+frameWriterAppendUint32(FrameWriter *  writer, uint32_t value)
+{
+	uint8_t	bytes[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+
+	frameWriterAppendBytes(writer, bytes, sizeof(bytes));
+}
+
+void
+frameWriterAppendFloat32(FrameWriter *  writer, const float *  values, size_t count)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	frameWriterAppendBytes(writer, values, count * sizeof(float));
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t	bits;
+
+		memcpy(&bits, &values[i], sizeof(bits));
+		frameWriterAppendUint32(writer, bits);
+	}
+#endif
+}
+
+void
+frameWriterAppendInt16(FrameWriter *  writer, const int16_t *  values, size_t count)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	frameWriterAppendBytes(writer, values, count * sizeof(int16_t));
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		frameWriterAppendUint16(writer, (uint16_t)values[i]);
+	}
+#endif
+}
+
+size_t
+frameWriterEncodeCentiCelsius(const float *  temperatures, size_t count, int16_t *  centiCelsius, uint8_t *  saturated)
+{
+	size_t	saturatedCount = 0;
+
+	for (size_t block = 0; block < count; block += kFrameWriterConstantEncodeBlockSize)
+	{
+		size_t	blockSize = (count - block < kFrameWriterConstantEncodeBlockSize) ? count - block : kFrameWriterConstantEncodeBlockSize;
+		uint8_t	flags[kFrameWriterConstantEncodeBlockSize];
+
+		/*
+		 *	Floating-point selects and conversions of NaN or out-of-range values
+		 *	keep compilers from vectorizing the loop, so values of |x| >= 2^30,
+		 *	infinities and NaN are first replaced by +-32769 with integer bit
+		 *	operations. Adding and subtracting 1.5 * 2^23 rounds to nearest, ties
+		 *	to even, exactly for all values in range. Vectorizes at -O3.
+		 */
+		for (size_t i = 0; i < blockSize; i++)
+		{
+			float	scaled = temperatures[block + i] * kFrameWriterConstantCentiCelsiusScale;
+			float	safe;
+			int32_t	bits;
+			int32_t	isNotNumber;
+			int32_t	isHuge;
+			int32_t	rounded;
+
+			memcpy(&bits, &scaled, sizeof(bits));
+			isNotNumber = ((bits & 0x7FFFFFFF) > 0x7F800000);
+			isHuge = ((bits & 0x7FFFFFFF) >= 0x4E800000);
+			bits = (bits & (isHuge - 1)) | ((bits & INT32_MIN) & -isHuge) | (0x47000100 & -isHuge);
+			memcpy(&safe, &bits, sizeof(safe));
+
+			rounded = (int32_t)((safe + 12582912.0f) - 12582912.0f);
+			flags[i] = isNotNumber | (rounded > INT16_MAX) | (rounded < INT16_MIN);
+			rounded = (rounded > INT16_MAX) ? INT16_MAX : rounded;
+			rounded = (rounded < INT16_MIN) ? INT16_MIN : rounded;
+			centiCelsius[block + i] = (int16_t)(rounded & (isNotNumber - 1));
+		}
+
+		for (size_t i = 0; i < blockSize / 8; i++)
+		{
+			uint8_t	byte = 0;
+
+			for (size_t bit = 0; bit < 8; bit++)
+			{
+				byte |= flags[8 * i + bit] << bit;
+			}
+			saturated[(block / 8) + i] = byte;
+			saturatedCount += __builtin_popcount(byte);
+		}
+	}
+
+	return saturatedCount;
+}
+
+size_t
+frameWriterEncodeSparse(const float *  temperatures, float *  reference, size_t count, float threshold, bool isKeyframe, uint16_t *  runs, float *  values, size_t *  valueCount)
+{
+	size_t	runCount = 0;
+	size_t	emittedCount = 0;
+	bool	isInRun = false;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		float	value = temperatures[i];
+		bool	isChanged = isKeyframe ||
+					(!(fabsf(value - reference[i]) <= threshold) && !(isnan(value) && isnan(reference[i])));
+
+		if (!isChanged)
+		{
+			isInRun = false;
+			continue;
+		}
+
+		if (!isInRun)
+		{
+			runs[2 * runCount] = (uint16_t)i;
+			runs[2 * runCount + 1] = 0;
+			runCount++;
+			isInRun = true;
+		}
+		runs[2 * runCount - 1]++;
+		values[emittedCount++] = value;
+		reference[i] = value;
+	}
+
+	*valueCount = emittedCount;
+
+	return runCount;
+}
+
+void
+frameWriterAppendFixed(FrameWriter *  writer, float value, unsigned int decimals)
+{
+	if (writer->length + kFrameWriterConstantMaxValueLength > writer->capacity)
+	{
+		frameWriterFlush(writer);
+	}
+
+	writer->length += formatFixed(&writer->buffer[writer->length], value, decimals);
+}
+
+void
+frameWriterAppendJSONNumber(FrameWriter *  writer, float value, unsigned int decimals)
+{
+	if (!isfinite(value))
+	{
+		frameWriterAppendString(writer, "null");
+		return;
+	}
+
+	frameWriterAppendFixed(writer, value, decimals);
+}
+
+void
+frameWriterAppendUnsigned(FrameWriter *  writer, uint64_t value)
+{
+	char	digits[20];
+	size_t	digitCount = 0;
+	char	string[sizeof(digits) + 1];
+	size_t	length = 0;
+
+	do
+	{
+		digits[digitCount++] = '0' + (value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	while (digitCount > 0)
+	{
+		string[length++] = digits[--digitCount];
+	}
+
+	frameWriterAppendBytes(writer, string, length);
+}
+
+CommonConstantReturnType
+frameWriterFlush(FrameWriter *  writer)
+{
+	fflush(writer->file);
+	writer->hasFailed |= (writeAll(fileno(writer->file), writer->buffer, writer->length) != kCommonConstantReturnTypeSuccess);
+	writer->length = 0;
+
+	return writer->hasFailed ? kCommonConstantReturnTypeError : kCommonConstantReturnTypeSuccess;
+}
+
+void
+frameWriterFree(FrameWriter *  writer)
+{
+	free(writer->buffer);
+	writer->buffer = NULL;
+	writer->length = writer->capacity = 0;
+}
+
+static CommonConstantReturnType
+writeAll(int fd, const char *  data, size_t size)
+{
+	size_t	written = 0;
+
+	while (written < size)
+	{
+		ssize_t	ret = write(fd, &data[written], size - written);
+
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return kCommonConstantReturnTypeError;
+		}
+		written += ret;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
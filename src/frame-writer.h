@@ -0,0 +1,232 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+/*
+ *	Encodings of the converted temperatures.
+ */
+typedef enum
+{
+	kOutputFormatText	= 0,	/* printf("%f") */
+	kOutputFormatFixed	= 1,	/* Same layout as kOutputFormatText, formatted with formatFixed() */
+	kOutputFormatFloat32	= 2,	/* Binary records of little-endian float32 temperatures, to the output file */
+	kOutputFormatInt16	= 3,	/* Binary records of int16 centi-Celsius and a saturation bitmap, to the output file */
+	kOutputFormatJSONLines	= 4,	/* One JSON object per frame, to the output file or stdout */
+	kOutputFormatSparse	= 5,	/* Binary records of the changed pixels only, with periodic keyframes, to the output file */
+} OutputFormat;
+
+/*
+ *	Binary temperature files start with a file header of kFrameWriterConstantFileHeaderSize
+ *	bytes: the magic "MLXT", the uint16 version, the uint16 OutputFormat, the uint32 number of
+ *	pixels per frame and the uint32 size of a record. Then follows one record per converted frame:
+ *	a record header of kFrameWriterConstantRecordHeaderSize bytes (uint32 frame index, uint32
+ *	sub-page, float32 ambient temperature in Celsius, float32 supply voltage in Volt) and the
+ *	temperatures of all pixels. All values are little-endian.
+ *
+ *	kOutputFormatInt16 records hold the temperatures as int16 in units of 0.01 Celsius, followed by
+ *	a bitmap with one bit per pixel (least significant bit first) that is set for pixels whose
+ *	temperature is outside the int16 range or not a number. These hold INT16_MAX, INT16_MIN, or
+ *	0 for NaN.
+ *
+ *	kOutputFormatSparse records have different sizes, so the file header holds a record size of 0.
+ *	The record header is followed by a uint16 of flags (kFrameWriterConstantSparseFlagKeyframe),
+ *	the uint16 number of runs, the runs as pairs of uint16 first pixel and uint16 pixel count, and
+ *	the float32 temperatures of all runs in order. Keyframes hold one run of all pixels.
+ */
+
+typedef enum
+{
+	kFrameWriterConstantDefaultCapacity	= 1 << 16,
+	kFrameWriterConstantMaxDecimals		= 9,
+	kFrameWriterConstantMaxValueLength	= 64,
+	kFrameWriterConstantFileMagic		= 0x54584C4D,	/* "MLXT" read as little-endian uint32 */
+	kFrameWriterConstantFileVersion		= 1,
+	kFrameWriterConstantFileHeaderSize	= 16,
+	kFrameWriterConstantRecordHeaderSize	= 16,
+	kFrameWriterConstantCentiCelsiusScale	= 100,
+	kFrameWriterConstantEncodeBlockSize	= 64,
+	kFrameWriterConstantSparseFlagKeyframe	= 1 << 0,
+} FrameWriterConstant;
+
+/*
+ *	Output buffer that is written to a file with as few write(2) calls as
+ *	possible: one per flush, as long as the buffer does not fill up.
+ */
+typedef struct FrameWriter
+{
+	FILE *		file;
+	char *		buffer;
+	size_t		length;
+	size_t		capacity;
+	bool		hasFailed;
+} FrameWriter;
+
+/**
+ *	@brief	Format a value like printf("%.*f", decimals, value), i.e., correctly rounded with ties to
+ *		even, without going through printf for finite values below about 2^33.
+ *
+ *	@param	dest		: Destination of at least kFrameWriterConstantMaxValueLength characters. Not NUL-terminated.
+ *	@param	value		: Value to format.
+ *	@param	decimals	: Number of decimals, at most kFrameWriterConstantMaxDecimals.
+ *	@return	size_t		: Number of characters written.
+ */
+size_t	formatFixed(char *  dest, float value, unsigned int decimals);
+
+/**
+ *	@brief	Allocate the buffer of a writer.
+ *
+ *	@param	writer		: Writer.
+ *	@param	file		: File to write to. Its stdio buffer is flushed before every write, so that
+ *				  output of the writer and of stdio functions stay in order.
+ *	@param	capacity	: Size of the buffer in bytes, at least kFrameWriterConstantMaxValueLength.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	frameWriterInit(FrameWriter *  writer, FILE *  file, size_t capacity);
+
+/**
+ *	@brief	Append a string, flushing first if it does not fit.
+ *
+ *	@param	writer		: Writer.
+ *	@param	string		: String.
+ */
+void	frameWriterAppendString(FrameWriter *  writer, const char *  string);
+
+/**
+ *	@brief	Append bytes, flushing first if they do not fit.
+ *
+ *	@param	writer		: Writer.
+ *	@param	data		: Bytes.
+ *	@param	size		: Number of bytes.
+ */
+void	frameWriterAppendBytes(FrameWriter *  writer, const void *  data, size_t size);
+
+/**
+ *	@brief	Append a little-endian uint16.
+ *
+ *	@param	writer		: Writer.
+ *	@param	value		: Value.
+ */
+void	frameWriterAppendUint16(FrameWriter *  writer, uint16_t value);
+
+/**
+ *	@brief	Append a little-endian uint32.
+ *
+ *	@param	writer		: Writer.
+ *	@param	value		: Value.
+ */
+void	frameWriterAppendUint32(FrameWriter *  writer, uint32_t value);
+
+/**
+ *	@brief	Append little-endian float32 values.
+ *
+ *	@param	writer		: Writer.
+ *	@param	values		: Values.
+ *	@param	count		: Number of values.
+ */
+void	frameWriterAppendFloat32(FrameWriter *  writer, const float *  values, size_t count);
+
+/**
+ *	@brief	Append little-endian int16 values.
+ *
+ *	@param	writer		: Writer.
+ *	@param	values		: Values.
+ *	@param	count		: Number of values.
+ */
+void	frameWriterAppendInt16(FrameWriter *  writer, const int16_t *  values, size_t count);
+
+/**
+ *	@brief	Convert temperatures to int16 centi-Celsius, rounded to nearest with ties to even, saturating
+ *		values out of range, and pack the saturation flags into a bitmap. The conversion loop is
+ *		branch-free so that compilers vectorize it.
+ *
+ *	@param	temperatures	: Temperatures in Celsius.
+ *	@param	count		: Number of temperatures, a multiple of 8.
+ *	@param	centiCelsius	: Destination of `count` values.
+ *	@param	saturated	: Destination of `count` / 8 bytes of saturation flags.
+ *	@return	size_t		: Number of saturated values.
+ */
+size_t	frameWriterEncodeCentiCelsius(const float *  temperatures, size_t count, int16_t *  centiCelsius, uint8_t *  saturated);
+
+/**
+ *	@brief	Find the pixels whose temperature changed by more than `threshold` since the value last
+ *		emitted for them, in a single pass that also updates `reference` to the emitted values.
+ *		A change between a number and NaN counts as a change, NaN staying NaN does not.
+ *
+ *	@param	temperatures	: Temperatures of the frame.
+ *	@param	reference	: Last emitted temperature of every pixel. Updated for the emitted pixels.
+ *	@param	count		: Number of pixels, at most UINT16_MAX.
+ *	@param	threshold	: Largest change in Celsius that is not emitted.
+ *	@param	isKeyframe	: Emit all pixels.
+ *	@param	runs		: Output array of at least `count` (first pixel, pixel count) pairs.
+ *	@param	values		: Output array of at least `count` temperatures of the runs.
+ *	@param	valueCount	: Number of temperatures written to `values`.
+ *	@return	Number of runs written to `runs`.
+ */
+size_t	frameWriterEncodeSparse(const float *  temperatures, float *  reference, size_t count, float threshold, bool isKeyframe, uint16_t *  runs, float *  values, size_t *  valueCount);
+
+/**
+ *	@brief	Append a value formatted with formatFixed(), flushing first if it might not fit.
+ *
+ *	@param	writer		: Writer.
+ *	@param	value		: Value.
+ *	@param	decimals	: Number of decimals, at most kFrameWriterConstantMaxDecimals.
+ */
+void	frameWriterAppendFixed(FrameWriter *  writer, float value, unsigned int decimals);
+
+/**
+ *	@brief	Append a JSON number formatted with formatFixed(), or `null` if the value is not finite.
+ *
+ *	@param	writer		: Writer.
+ *	@param	value		: Value.
+ *	@param	decimals	: Number of decimals, at most kFrameWriterConstantMaxDecimals.
+ */
+void	frameWriterAppendJSONNumber(FrameWriter *  writer, float value, unsigned int decimals);
+
+/**
+ *	@brief	Append an unsigned integer in decimal.
+ *
+ *	@param	writer		: Writer.
+ *	@param	value		: Value.
+ */
+void	frameWriterAppendUnsigned(FrameWriter *  writer, uint64_t value);
+
+/**
+ *	@brief	Write the buffer with write(2), retrying partial writes.
+ *
+ *	@param	writer		: Writer.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if this and all earlier writes were successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	frameWriterFlush(FrameWriter *  writer);
+
+/**
+ *	@brief	Release the buffer of a writer. Does not flush it.
+ *
+ *	@param	writer		: Writer.
+ */
+void	frameWriterFree(FrameWriter *  writer);
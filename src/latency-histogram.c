@@ -0,0 +1,192 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "latency-histogram.h"
+
+static const double	kPercentiles[kLatencyHistogramConstantPercentileCount] = { 50, 90, 99, 99.9, 100 };
+
+/**
+ *	@brief	Index of the bucket holding a value.
+ *
+ *	@param	value		: Value in nanoseconds.
+ *	@return	size_t		: Bucket index.
+ */
+static size_t	bucketIndex(uint64_t value);
+
+/**
+ *	@brief	Largest value falling into a bucket.
+ *
+ *	@param	index		: Bucket index.
+ *	@return	uint64_t	: Upper edge of the bucket in nanoseconds.
+ */
+static uint64_t	bucketUpperEdge(size_t index);
+
+static size_t
+bucketIndex(uint64_t value)
+{
+	const unsigned int	subBucketBits = kLatencyHistogramConstantSubBucketBits;
+	unsigned int		exponent;
+
+	if (value < (1ULL << subBucketBits))
+	{
+		return value;
+	}
+
+	if (value >= (1ULL << kLatencyHistogramConstantMaxValueBits))
+	{
+		return kLatencyHistogramConstantBucketCount - 1;
+	}
+
+	/*
+	 *	For 2^exponent <= value < 2^(exponent + 1), keep the subBucketBits most
+	 *	significant bits; the leading one is implied by the exponent.
+	 */
+	exponent = 63 - __builtin_clzll(value);
+
+	return (1U << subBucketBits) +
+		(exponent - subBucketBits) * (1U << (subBucketBits - 1)) +
+		((value >> (exponent - subBucketBits + 1)) & ((1U << (subBucketBits - 1)) - 1));
+}
+
+static uint64_t
+bucketUpperEdge(size_t index)
+{
+	const unsigned int	subBucketBits = kLatencyHistogramConstantSubBucketBits;
+	size_t			octave;
+	uint64_t		subBucket;
+	unsigned int		shift;
+
+	if (index < (1U << subBucketBits))
+	{
+		return index;
+	}
+
+	octave = (index - (1U << subBucketBits)) >> (subBucketBits - 1);
+	subBucket = (index - (1U << subBucketBits)) & ((1U << (subBucketBits - 1)) - 1);
+	shift = octave + 1;
+
+	return (((1ULL << (subBucketBits - 1)) + subBucket + 1) << shift) - 1;
+}
+
+void
+latencyHistogramInit(LatencyHistogram *  histogram)
+{
+	memset(histogram, 0, sizeof(*histogram));
+	histogram->minimum = UINT64_MAX;
+}
+
+void
+latencyHistogramRecord(LatencyHistogram *  histogram, uint64_t nanoseconds)
+{
+	if (histogram == NULL)
+	{
+		return;
+	}
+
+	histogram->counts[bucketIndex(nanoseconds)]++;
+	histogram->totalCount++;
+	histogram->sum += nanoseconds;
+	histogram->minimum = (nanoseconds < histogram->minimum) ? nanoseconds : histogram->minimum;
+	histogram->maximum = (nanoseconds > histogram->maximum) ? nanoseconds : histogram->maximum;
+}
+
+uint64_t
+latencyHistogramPercentile(const LatencyHistogram *  histogram, double percentile)
+{
+	uint64_t	rank;
+	uint64_t	seen = 0;
+
+	if (histogram->totalCount == 0)
+	{
+		return 0;
+	}
+
+	/*
+	 *	Nearest rank, at least the first value.
+	 */
+	rank = (uint64_t)(percentile / 100 * histogram->totalCount + 0.5);
+	rank = (rank == 0) ? 1 : rank;
+
+	for (size_t i = 0; i < kLatencyHistogramConstantBucketCount; i++)
+	{
+		seen += histogram->counts[i];
+		if (seen >= rank)
+		{
+			uint64_t	edge = bucketUpperEdge(i);
+
+			return (edge < histogram->maximum) ? edge : histogram->maximum;
+		}
+	}
+
+	return histogram->maximum;
+}
+
+void
+latencyHistogramSummarize(LatencyHistogram *  histogram)
+{
+	for (size_t p = 0; p < kLatencyHistogramConstantPercentileCount; p++)
+	{
+		histogram->percentileSeconds[p] = latencyHistogramPercentile(histogram, kPercentiles[p]) * 1e-9;
+	}
+	histogram->meanSeconds = (histogram->totalCount > 0) ? histogram->sum * 1e-9 / histogram->totalCount : 0;
+}
+
+void
+latencyHistogramPrint(const LatencyHistogram *  histogram, FILE *  stream)
+{
+	fprintf(
+		stream,
+		"Latency (%" PRIu64 " frames, microseconds): min %.1f mean %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+		histogram->totalCount,
+		(histogram->totalCount > 0) ? histogram->minimum * 1e-3 : 0.0,
+		histogram->meanSeconds * 1e6,
+		histogram->percentileSeconds[0] * 1e6,
+		histogram->percentileSeconds[1] * 1e6,
+		histogram->percentileSeconds[2] * 1e6,
+		histogram->percentileSeconds[3] * 1e6,
+		histogram->percentileSeconds[4] * 1e6);
+}
+
+size_t
+latencyHistogramGetJSONVariables(LatencyHistogram *  histogram, JSONvariable *  variables)
+{
+	variables[0] = (JSONvariable) {
+		.variableSymbol = "latencyPercentileSeconds",
+		.variableDescription = "Frame latency in seconds (p50, p90, p99, p99.9, max)",
+		.values = (JSONvariablePointer) { .asDouble = histogram->percentileSeconds },
+		.type = kJSONvariableTypeDouble,
+		.size = kLatencyHistogramConstantPercentileCount,
+	};
+	variables[1] = (JSONvariable) {
+		.variableSymbol = "latencyMeanSeconds",
+		.variableDescription = "Mean frame latency in seconds",
+		.values = (JSONvariablePointer) { .asDouble = &histogram->meanSeconds },
+		.type = kJSONvariableTypeDouble,
+		.size = 1,
+	};
+
+	return kLatencyHistogramConstantJSONVariableCount;
+}
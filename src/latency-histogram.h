@@ -0,0 +1,110 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+/*
+ *	Log-linear buckets: values below 2^kLatencyHistogramConstantSubBucketBits nanoseconds get one
+ *	bucket per nanosecond, every further power of two is split into 2^(kLatencyHistogramConstantSubBucketBits - 1)
+ *	buckets, so that every recorded value is within 1/128 (0.8 %) of its bucket. Values up to
+ *	2^kLatencyHistogramConstantMaxValueBits nanoseconds (68 seconds) are resolved, larger values
+ *	fall into the last bucket.
+ */
+typedef enum
+{
+	kLatencyHistogramConstantSubBucketBits		= 8,
+	kLatencyHistogramConstantMaxValueBits		= 36,
+	kLatencyHistogramConstantBucketCount		= (1 << kLatencyHistogramConstantSubBucketBits) +
+							  (kLatencyHistogramConstantMaxValueBits - kLatencyHistogramConstantSubBucketBits) *
+							  (1 << (kLatencyHistogramConstantSubBucketBits - 1)),
+	kLatencyHistogramConstantPercentileCount	= 5,
+	kLatencyHistogramConstantJSONVariableCount	= 2,
+} LatencyHistogramConstant;
+
+typedef struct LatencyHistogram
+{
+	uint64_t	counts[kLatencyHistogramConstantBucketCount];
+	uint64_t	totalCount;
+	uint64_t	minimum;
+	uint64_t	maximum;
+	double		sum;
+
+	/*
+	 *	Filled in by latencyHistogramSummarize(), in seconds: p50, p90, p99, p99.9 and max.
+	 */
+	double		percentileSeconds[kLatencyHistogramConstantPercentileCount];
+	double		meanSeconds;
+} LatencyHistogram;
+
+/**
+ *	@brief	Empty a histogram.
+ *
+ *	@param	histogram	: Histogram.
+ */
+void	latencyHistogramInit(LatencyHistogram *  histogram);
+
+/**
+ *	@brief	Record one latency.
+ *
+ *	@param	histogram	: Histogram, or NULL to do nothing.
+ *	@param	nanoseconds	: Latency in nanoseconds.
+ */
+void	latencyHistogramRecord(LatencyHistogram *  histogram, uint64_t nanoseconds);
+
+/**
+ *	@brief	Latency below which a given fraction of the recorded latencies lie.
+ *
+ *	@param	histogram	: Histogram.
+ *	@param	percentile	: Percentile in [0, 100].
+ *	@return	uint64_t	: Upper edge of the bucket holding the percentile in nanoseconds, at most the maximum recorded.
+ */
+uint64_t	latencyHistogramPercentile(const LatencyHistogram *  histogram, double percentile);
+
+/**
+ *	@brief	Compute the p50, p90, p99, p99.9, max and mean latencies.
+ *
+ *	@param	histogram	: Histogram.
+ */
+void	latencyHistogramSummarize(LatencyHistogram *  histogram);
+
+/**
+ *	@brief	Print a summarized histogram on one line.
+ *
+ *	@param	histogram	: Histogram.
+ *	@param	stream		: Output stream.
+ */
+void	latencyHistogramPrint(const LatencyHistogram *  histogram, FILE *  stream);
+
+/**
+ *	@brief	Describe a summarized histogram as JSON variables, for printJSONVariables().
+ *
+ *	@param	histogram	: Histogram.
+ *	@param	variables	: Destination of kLatencyHistogramConstantJSONVariableCount variables.
+ *	@return	size_t		: Number of variables written.
+ */
+size_t	latencyHistogramGetJSONVariables(LatencyHistogram *  histogram, JSONvariable *  variables);
@@ -26,37 +26,193 @@
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
-#include <time.h>
 #include <uxhw.h>
 #include <MLX90640_API.h>
+#include <MLX90640_I2C_Driver.h>
 #include "utilities.h"
 #include "common.h"
+#include "mlx90640-conversion.h"
+#include "mlx90640-fixed-point.h"
+#include "mlx90640-i2c.h"
+#include "timing.h"
+#include "performance-counters.h"
+#include "latency-histogram.h"
+#include "trace.h"
+#include "metrics.h"
+#include "frame-writer.h"
+#include "shm-ring.h"
+#include "server.h"
+#include "frame-reader.h"
+#include "frame-prefetcher.h"
+#include "batch-reader.h"
+
+/*
+ *	Calibration and last temperatures of a sensor of the conversion server.
+ */
+typedef struct ServerSensor
+{
+	paramsMLX90640	params;
+	float		temperatures[kMLX90640ConstantFrameBufferSize];
+	uint32_t	frameCount;
+} ServerSensor;
 
 static uint16_t	eeData[kMLX90640ConstantEEDataBufferSize];
 static uint16_t	rawDataFrame[kMLX90640ConstantRawFrameBufferSize];
+static uint16_t *	frameData = rawDataFrame;
 static float	mlx90640To[kMLX90640ConstantFrameBufferSize];
+static _Alignas(kMLX90640ConstantCacheLineSize) float	emissivityMap[kMLX90640ConstantFrameBufferSize];
+static float *	emissivitySweep;
+static float *	emissivitySweepTable;
+static double	mlx90640ToDouble[kMLX90640ConstantFrameBufferSize];
+static double *	emissivitySweepTableDouble;
+static uint16_t	mlx90640ToCentiKelvin[kMLX90640ConstantFrameBufferSize];
+static MLX90640FixedPointParams	fixedPointParams;
+static LatencyHistogram	latencyHistogram;
+static FrameWriter	frameWriter;
+static FrameWriter	frameOutputWriter;
+static FILE *	frameOutputFile;
+static bool	isFrameOutputEnabled;
+static int16_t	mlx90640ToCentiCelsius[kMLX90640ConstantFrameBufferSize];
+static uint8_t	saturationBitmap[kMLX90640ConstantFrameBufferSize / 8];
+static float	sparseReference[kMLX90640ConstantFrameBufferSize];
+static uint16_t	sparseRuns[2 * kMLX90640ConstantFrameBufferSize];
+static float	sparseValues[kMLX90640ConstantFrameBufferSize];
+static size_t	sparseRecordCount;
+static ShmRing	inputRing;
+static ShmRing	outputRing;
+static ServerSensor *	serverSensors;
+static size_t	serverSensorCount;
+static FrameReader	frameReader = { .fd = -1 };
+static FramePrefetcher	framePrefetcher;
+static BatchReader	batchReader = { .ring = { .fd = -1 } };
+static uint16_t	recordedEEData[kMLX90640ConstantEEDataBufferSize];
+static uint16_t *	recordedFrames;
+static size_t	recordedFrameCount;
 
 /**
  *	@brief	Convert a data raw data frame to array of temperatures.
  *
  *	@param	mlx90640Params	: Parameters of MLX90640 sensor.
  *	@param	line		: Line in raw data CSV file to parse. Each line contains one raw data frame.
+ *				  When replaying, the frame is acquired from the I2C driver instead.
+ *	@param	arguments	: Pointer to command line arguments struct.
+ *	@param	timing		: Timing report to charge the stages of the frame to, or NULL.
+ *	@param	counters	: Performance counters to charge the parse and kernel stages to, or NULL.
+ *	@param	latency		: Histogram to record the latency of the frame in, or NULL.
+ *	@return	int		: Size of raw data frame that was converted if successful, 0 if the frame was
+ *				  dropped because it could not be acquired or was incomplete, else -1.
+ */
+static int processDataFrame(
+	paramsMLX90640 *  mlx90640Params,
+	size_t line,
+	CommandLineArguments *  arguments,
+	TimingReport *  timing,
+	PerformanceCounters *  counters,
+	LatencyHistogram *  latency);
+
+/**
+ *	@brief	Charge the time since `begin` to a stage of the timing report and of the metrics.
+ *
+ *	@param	timing		: Timing report, or NULL.
+ *	@param	stage		: Stage to charge.
+ *	@param	begin		: Start of the stage, or 0 if neither timing nor metrics are enabled.
+ *	@return	uint64_t	: The current time, to be used as the start of the next stage, or 0 if `begin` is 0.
+ */
+static uint64_t recordStage(TimingReport *  timing, TimingStage stage, uint64_t begin);
+
+/**
+ *	@brief	Print the [emissivity][pixel] table of an emissivity sweep, or the selected pixel for every emissivity.
+ *
+ *	@param	arguments	: Pointer to command line arguments struct.
+ *	@param	timing		: Summarized timing report to include in the JSON output, or NULL.
+ *	@param	latency		: Summarized latency histogram to include in the JSON output, or NULL.
+ */
+static void printEmissivitySweep(CommandLineArguments *  arguments, TimingReport *  timing, LatencyHistogram *  latency);
+
+/**
+ *	@brief	Write a frame of temperatures with `frameWriter`, in the layout of printf("%f ") per pixel and
+ *		one line per row, with one write(2).
+ *
+ *	@param	temperatures	: Temperatures of the frame.
+ */
+static void writeTemperatureFrame(const float *  temperatures);
+
+/**
+ *	@brief	Open the output file of a binary format and write its file header.
+ *
+ *	@param	arguments	: Pointer to command line arguments struct.
+ */
+static void setUpFrameOutput(CommandLineArguments *  arguments);
+
+/**
+ *	@brief	Append the record of a converted frame to the output file of a binary format.
+ *
+ *	@param	arguments	: Pointer to command line arguments struct.
+ *	@param	frameIndex	: Index of the frame in the recording.
+ *	@param	ta		: Ambient temperature of the frame in Celsius.
+ *	@param	vdd		: Supply voltage of the frame in Volt.
+ */
+static void writeFrameOutput(CommandLineArguments *  arguments, size_t frameIndex, float ta, float vdd);
+
+/**
+ *	@brief	Map the shared memory ring of raw frames and create the ring of temperature frames.
+ *
  *	@param	arguments	: Pointer to command line arguments struct.
- *	@return	int		: Size of raw data frame that was converted if successful, else -1.
  */
-static int processDataFrame(paramsMLX90640 *  mlx90640Params, size_t line, CommandLineArguments *  arguments);
+static void setUpSharedMemoryRings(CommandLineArguments *  arguments);
 
 /**
- *	@brief	Calculate calibrated temperatures frame. Modified from Melexis original library to model ADC quantization error.
+ *	@brief	Wait for a free slot of the temperature ring and publish the converted frame into it, as a
+ *		record of the f32 output format.
  *
- *	@param	frameData		: Raw data frame from MLX90640.
- *	@param	params			: Parameters of MLX90640 sensor.
- *	@param	emissivity		: Emissivity of the measured object.
- *	@param	tr			: Reflected temperature based on the sensor ambient temperature.
- *	@param	result			: Pointer to float array for storing calibrated temperatures.
- *	@param	quantizationError	: Enable modeling of ADC quantization error.
+ *	@param	frameIndex	: Index of the frame in the input ring.
+ *	@param	ta		: Ambient temperature of the frame in Celsius.
+ *	@param	vdd		: Supply voltage of the frame in Volt.
  */
-static void MLX90640_CalculateTo_UT(uint16_t *  frameData, const paramsMLX90640 *  params, float emissivity, float tr, float *  result, bool quantizationError);
+static void publishTemperatureFrame(size_t frameIndex, float ta, float vdd);
+
+/**
+ *	@brief	Return the raw frame that was converted in place to the shared memory ring or prefetcher it came from.
+ */
+static void releaseFrameData(void);
+
+/**
+ *	@brief	Extract the calibration of every line of the EEPROM file, one sensor id per line, and answer
+ *		conversion requests on the server socket until SIGINT or SIGTERM.
+ *
+ *	@param	arguments	: Pointer to command line arguments struct.
+ *	@return	int		: Exit status.
+ */
+static int serveConversions(CommandLineArguments *  arguments);
+
+/**
+ *	@brief	Convert a raw frame of a server request with the calibration of its sensor. Pixels of the
+ *		other sub-page keep the temperatures of the sensor's previous frame.
+ *
+ *	@param	context		: Pointer to command line arguments struct.
+ *	@param	sensorId	: Sensor id, the line of its calibration in the EEPROM file.
+ *	@param	frame		: Raw frame.
+ *	@param	record		: Destination of the f32 output record of the frame.
+ *	@return	bool		: false if there is no calibration for the sensor.
+ */
+static bool convertServerFrame(void *  context, uint32_t sensorId, uint16_t *  frame, uint8_t *  record);
+
+/**
+ *	@brief	Describe the summarized timing report and latency histogram as JSON variables.
+ *
+ *	@param	timing		: Timing report, or NULL.
+ *	@param	latency		: Latency histogram, or NULL.
+ *	@param	variables	: Destination of up to kTimingConstantJSONVariableCount + kLatencyHistogramConstantJSONVariableCount variables.
+ *	@return	size_t		: Number of variables written.
+ */
+static size_t getReportJSONVariables(TimingReport *  timing, LatencyHistogram *  latency, JSONvariable *  variables);
+
+/**
+ *	@brief	Load the raw frame recording and set up the I2C replay driver, then read the EEPROM through it.
+ *
+ *	@param	arguments	: Pointer to command line arguments struct.
+ */
+static void setUpReplay(CommandLineArguments *  arguments);
 
 int
 main(int argc, char *  argv[])
@@ -64,9 +220,18 @@ main(int argc, char *  argv[])
 	CommandLineArguments	arguments;
 	paramsMLX90640		mlx90640Params = { 0 };
 	float			pixelTemp = 0.0;
-	clock_t			start = 0;
-	clock_t			end = 0;
-	double			cpuTimeUsed;
+	TimingReport		timingReport = { 0 };
+	TimingReport *		timing = NULL;
+	uint64_t		stageBegin = 0;
+	uint64_t		loopBegin;
+	PerformanceCounters	performanceCounters;
+	PerformanceCounters *	counters = NULL;
+	LatencyHistogram *	latency = NULL;
+	uint64_t		lastLatencyReport = 0;
+	uint64_t		loopEnd;
+	uint64_t		traceStageBegin;
+	bool			isStdoutStreamed;
+	size_t			convertedFrameCount;
 
 	/*
 	 *	Get command line arguments.
@@ -76,323 +241,1150 @@ main(int argc, char *  argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	if ((strcmp(arguments.tracePath, "") != 0) && (traceInit(arguments.tracePath) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error: Could not open trace file '%s'.\n", arguments.tracePath);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((arguments.outputFormat == kOutputFormatFixed) &&
+		(frameWriterInit(&frameWriter, stdout, kFrameWriterConstantDefaultCapacity) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in allocating output buffer\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (arguments.outputFormat >= kOutputFormatFloat32)
+	{
+		setUpFrameOutput(&arguments);
+	}
+	isStdoutStreamed = (frameOutputFile == stdout);
+
+	if ((strcmp(arguments.metricsPath, "") != 0) && (metricsStart(arguments.metricsPath) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error: Could not write metrics file '%s'.\n", arguments.metricsPath);
+		exit(EXIT_FAILURE);
+	}
+
 	/*
 	 *	Load ee data from sensor
 	 */
-	if (readUint16DataFromCSV(eeData, 0, kMLX90640ConstantEEDataBufferSize, arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
+	if (readUint16DataFromCSV(
+		arguments.isReplayEnabled ? recordedEEData : eeData,
+		0,
+		kMLX90640ConstantEEDataBufferSize,
+		arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
 	{
 		fprintf(stderr, "Error in reading sensor ee data\n");
 		exit(EXIT_FAILURE);
 	}
 
+	if (arguments.isReplayEnabled)
+	{
+		setUpReplay(&arguments);
+	}
+
+	if (strcmp(arguments.shmInputName, "") != 0)
+	{
+		setUpSharedMemoryRings(&arguments);
+	}
+	else if (arguments.isRawDataDirectory && (strcmp(arguments.serverSocketPath, "") == 0))
+	{
+		if (batchReaderOpen(&batchReader, arguments.rawDataPath, arguments.inputFormat, arguments.filesInFlight, kBatchReaderBackendIoUring) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error in opening the recordings of directory '%s'\n", arguments.rawDataPath);
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if (!arguments.isReplayEnabled && (strcmp(arguments.serverSocketPath, "") == 0) &&
+		(frameReaderOpen(&frameReader, arguments.rawDataPath, arguments.inputFormat) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in opening raw frame input '%s'\n", arguments.rawDataPath);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((frameReader.fd >= 0) && (arguments.prefetchDepth > 0) &&
+		(framePrefetcherStart(&framePrefetcher, &frameReader, kMLX90640ConstantRawFrameBufferSize, arguments.prefetchDepth) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in starting the raw frame prefetcher\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 *	Load per-pixel emissivities
+	 */
+	if ((strcmp(arguments.emissivityMapPath, "") != 0) && (readEmissivityMap(emissivityMap, arguments.emissivityMapPath) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in reading emissivity map\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (strcmp(arguments.serverSocketPath, "") != 0)
+	{
+		return serveConversions(&arguments);
+	}
+
 	/*
-	 *	Start timing.
+	 *	Set up the emissivity sweep and its dense [emissivity][pixel] table
 	 */
+	if (arguments.emissivitySweepCount > 0)
+	{
+		emissivitySweep = calloc(arguments.emissivitySweepCount, sizeof(float));
+		emissivitySweepTable = calloc(arguments.emissivitySweepCount * kMLX90640ConstantFrameBufferSize, sizeof(float));
+
+		if (arguments.precision == kMLX90640PrecisionDouble)
+		{
+			emissivitySweepTableDouble = calloc(arguments.emissivitySweepCount * kMLX90640ConstantFrameBufferSize, sizeof(double));
+		}
+
+		if ((emissivitySweep == NULL) || (emissivitySweepTable == NULL) ||
+			((arguments.precision == kMLX90640PrecisionDouble) && (emissivitySweepTableDouble == NULL)))
+		{
+			fprintf(stderr, "Error in allocating emissivity sweep table\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (size_t e = 0; e < arguments.emissivitySweepCount; e++)
+		{
+			emissivitySweep[e] = arguments.emissivitySweepStart + e * arguments.emissivitySweepStep;
+		}
+	}
+
 	if (arguments.common.isTimingEnabled)
 	{
-		start = clock();
+		timingInit(&timingReport);
+		timing = &timingReport;
+	}
+
+	if (arguments.latencyReportPeriod >= 0)
+	{
+		latencyHistogramInit(&latencyHistogram);
+		latency = &latencyHistogram;
+		lastLatencyReport = getMonotonicTimeNanoseconds();
+	}
+
+	if (arguments.isPerformanceCountersEnabled)
+	{
+		if (performanceCountersOpen(&performanceCounters))
+		{
+			counters = &performanceCounters;
+		}
+		else
+		{
+			fprintf(stderr, "Warning: Hardware performance counters are not available, continuing without them.\n");
+		}
 	}
 
 	/*
 	 *	Loop process kernel. This is used when benchmarking equivalent monte carlo
 	 *	execution time. In all other cases i == 1; 
 	 */
+	loopBegin = getMonotonicTimeNanoseconds();
 	for (size_t j = 0; j < arguments.common.numberOfMonteCarloIterations; ++j)
 	{
+		if ((j > 0) && (frameReader.fd >= 0))
+		{
+			/*
+			 *	The prefetcher read ahead to the end of the input and
+			 *	is restarted behind the rewound reader.
+			 */
+			framePrefetcherStop(&framePrefetcher);
+			if ((frameReaderRewind(&frameReader) != kCommonConstantReturnTypeSuccess) ||
+				((arguments.prefetchDepth > 0) &&
+				(framePrefetcherStart(&framePrefetcher, &frameReader, kMLX90640ConstantRawFrameBufferSize, arguments.prefetchDepth) != kCommonConstantReturnTypeSuccess)))
+			{
+				fprintf(stderr, "Error in rewinding raw frame input\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		if ((j > 0) && (batchReader.paths != NULL))
+		{
+			batchReaderClose(&batchReader);
+			if (batchReaderOpen(&batchReader, arguments.rawDataPath, arguments.inputFormat, arguments.filesInFlight, kBatchReaderBackendIoUring) != kCommonConstantReturnTypeSuccess)
+			{
+				fprintf(stderr, "Error in opening the recordings of directory '%s'\n", arguments.rawDataPath);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		stageBegin = ((timing != NULL) || metricsIsEnabled()) ? getMonotonicTimeNanoseconds() : 0;
+		traceStageBegin = traceBegin();
+
 		if (MLX90640_ExtractParameters(eeData, &mlx90640Params))
 		{
 			fprintf(stderr, "Error in extracting parameters from EE\n");
 			exit(EXIT_FAILURE);
 		}
 
+		if (arguments.precision == kMLX90640PrecisionFixedPoint)
+		{
+			MLX90640_PrepareFixedPointParameters(&mlx90640Params, arguments.emissivity, kMLX90640ConstantTaShift, &fixedPointParams);
+		}
+
+		recordStage(timing, kTimingStageExtract, stageBegin);
+		traceEnd("MLX90640_ExtractParameters", traceStageBegin, kTraceConstantNoArgument);
+
 		/*
 		 *	Conversion routines need to process at least 2 sub-pages.
 		 */
+		convertedFrameCount = 0;
 		for (size_t i = 0;; i++)
 		{
 			/*
 			 *	processDataFrame returns -1 when line i does not contain a 
-			 *	valid mlx90640 frame
+			 *	valid mlx90640 frame, and 0 when the frame was dropped.
 			 */
-			if (processDataFrame(&mlx90640Params, i, &arguments) == -1)
+			int	frameSize = processDataFrame(&mlx90640Params, i, &arguments, timing, counters, latency);
+
+			if (frameSize == -1)
 			{
-				if (i < 1)
+				if (convertedFrameCount == 0)
 				{
 					fprintf(stderr, "Error in reading sensor raw data\n");
 					exit(EXIT_FAILURE);
 				}
 				break;
 			}
+			if (frameSize > 0)
+			{
+				convertedFrameCount++;
+			}
+
+			/*
+			 *	Periodic reports are cumulative and go to stderr, so that they
+			 *	do not mix with the results.
+			 */
+			if ((latency != NULL) && (arguments.latencyReportPeriod > 0) &&
+				(getMonotonicTimeNanoseconds() - lastLatencyReport >= arguments.latencyReportPeriod * 1e9))
+			{
+				latencyHistogramSummarize(latency);
+				latencyHistogramPrint(latency, stderr);
+				lastLatencyReport = getMonotonicTimeNanoseconds();
+			}
 		}
 
+		/*
+		 *	Repeated executions convert the same frames, which are written once.
+		 */
+		isFrameOutputEnabled = false;
+
 		doNotOptimize((void*)mlx90640To);
+		doNotOptimize((void*)emissivitySweepTable);
 
-		pixelTemp = mlx90640To[arguments.pixel];
+		pixelTemp = (arguments.emissivitySweepCount > 0) ? emissivitySweepTable[arguments.pixel] : mlx90640To[arguments.pixel];
 	}
+	loopEnd = getMonotonicTimeNanoseconds();
 
 	/*
-	 *	Stop timing.
+	 *	The JSON output includes the timing report, so it cannot include the
+	 *	time spent printing it.
 	 */
-	if (arguments.common.isTimingEnabled)
+	if ((timing != NULL) && arguments.common.isOutputJSONMode)
 	{
-		end = clock();
-		cpuTimeUsed = ((double)(end - start)) / CLOCKS_PER_SEC;
+		timingSummarize(timing);
 	}
+	if (latency != NULL)
+	{
+		latencyHistogramSummarize(latency);
+	}
+	stageBegin = (timing != NULL) ? getMonotonicTimeNanoseconds() : 0;
+	traceStageBegin = traceBegin();
 
 	/*
-	 *	Print outputs.
+	 *	JSON Lines streamed to stdout already contain every frame, any other
+	 *	output would break the stream.
 	 */
-	if (!arguments.common.isOutputJSONMode)
+	if (!isStdoutStreamed)
 	{
-		printf("Converting raw data to temperature using emissivity = %f\n", arguments.emissivity);
+		/*
+		 *	Print benchmarking outputs: the selected pixel (of the first emissivity of
+		 *	a sweep), the time per kernel iteration in microseconds, the number of
+		 *	iterations and a checksum of all temperatures.
+		 */
+		if (arguments.common.isBenchmarkingMode)
+		{
+			uint64_t	checksum = (arguments.emissivitySweepCount > 0)
+							? computeChecksum(emissivitySweepTable, arguments.emissivitySweepCount * kMLX90640ConstantFrameBufferSize * sizeof(float))
+							: computeChecksum(mlx90640To, sizeof(mlx90640To));
+
+			printf(
+				"%lf %.3lf %zu %016" PRIx64 "\n",
+				pixelTemp,
+				((loopEnd - loopBegin) * 1e-3) / arguments.common.numberOfMonteCarloIterations,
+				arguments.common.numberOfMonteCarloIterations,
+				checksum);
+		}
 
-		if (!arguments.printAllTemperatures)
+		/*
+		 *	Print emissivity sweep outputs.
+		 */
+		else if (arguments.emissivitySweepCount > 0)
 		{
-			printf("Temperature of pixel %u: %f Celsius.\n\n", arguments.pixel, pixelTemp);
+			printEmissivitySweep(&arguments, timing, latency);
 		}
-		else
+
+		/*
+		 *	Print outputs.
+		 */
+		else if (!arguments.common.isOutputJSONMode)
 		{
-			for (size_t h = 0; h < kMLX90640ConstantFrameHeight; h++)
+			if (strcmp(arguments.emissivityMapPath, "") != 0)
+			{
+				printf("Converting raw data to temperature using emissivity map '%s'\n", arguments.emissivityMapPath);
+			}
+			else
+			{
+				printf("Converting raw data to temperature using emissivity = %f\n", arguments.emissivity);
+			}
+
+			if (!arguments.printAllTemperatures)
+			{
+				printf("Temperature of pixel %u: %f Celsius.\n\n", arguments.pixel, pixelTemp);
+			}
+			else if (arguments.outputFormat == kOutputFormatFixed)
+			{
+				writeTemperatureFrame(mlx90640To);
+			}
+			else
 			{
-				for (size_t w = 0; w < kMLX90640ConstantFrameWidth; w++)
+				for (size_t h = 0; h < kMLX90640ConstantFrameHeight; h++)
 				{
-					printf("%f ", mlx90640To[h * kMLX90640ConstantFrameWidth + w]);
+					for (size_t w = 0; w < kMLX90640ConstantFrameWidth; w++)
+					{
+						printf("%f ", mlx90640To[h * kMLX90640ConstantFrameWidth + w]);
+					}
+					printf("\n");
 				}
-				printf("\n");
 			}
 		}
-	}
 
-	/*
-	 *	Print json outputs.
-	 */
-	if (arguments.common.isOutputJSONMode)
-	{
-		if (!arguments.printAllTemperatures)
+		/*
+		 *	Print json outputs.
+		 */
+		else
 		{
-			JSONvariable variables[] = {
-				{
+			JSONvariable	variables[1 + kTimingConstantJSONVariableCount + kLatencyHistogramConstantJSONVariableCount];
+			size_t		variableCount = 1;
+
+			if (!arguments.printAllTemperatures)
+			{
+				variables[0] = (JSONvariable) {
 					.variableSymbol = "temperature",
 					.variableDescription = "Temperature (calibrated)",
 					.values = (JSONvariablePointer) { .asFloat = &pixelTemp },
 					.type = kJSONvariableTypeFloat,
 					.size = 1,
-				},
-			};
-
-			printJSONVariables(variables, 1, "MLX90640 Conversion Values.");
-		}
-		else
-		{
-			JSONvariable variables[] = {
-				{
+				};
+			}
+			else
+			{
+				variables[0] = (JSONvariable) {
 					.variableSymbol = "temperatures",
 					.variableDescription = "Temperatures (calibrated)",
 					.values = (JSONvariablePointer) { .asFloat = mlx90640To },
 					.type = kJSONvariableTypeFloat,
 					.size = kMLX90640ConstantFrameBufferSize,
-				},
-			};
+				};
+			}
 
-			printJSONVariables(variables, 1, "MLX90640 Conversion Values.");
+			variableCount += getReportJSONVariables(timing, latency, &variables[variableCount]);
+			printJSONVariables(variables, variableCount, "MLX90640 Conversion Values.");
 		}
 	}
+	traceEnd("output", traceStageBegin, kTraceConstantNoArgument);
 
 	/*
 	 *	Print timing results.
 	 */
-	if ((arguments.common.isTimingEnabled) && (!arguments.common.isOutputJSONMode))
+	if ((timing != NULL) && (!arguments.common.isOutputJSONMode) && (!isStdoutStreamed))
 	{
-		printf("CPU time used: %lf seconds\n", cpuTimeUsed);
+		timingRecordStage(timing, kTimingStageOutput, stageBegin);
+		timingSummarize(timing);
+		timingPrint(timing);
 	}
 
+	if ((latency != NULL) && (!arguments.common.isOutputJSONMode) && (!arguments.common.isBenchmarkingMode) && (!isStdoutStreamed))
+	{
+		latencyHistogramPrint(latency, stdout);
+	}
+
+	if (arguments.isPerformanceCountersEnabled && (!arguments.common.isOutputJSONMode) && (!arguments.common.isBenchmarkingMode) && (!isStdoutStreamed))
+	{
+		performanceCountersPrint(&performanceCounters, kMLX90640ConstantFrameBufferSize / 2);
+	}
+	if (counters != NULL)
+	{
+		performanceCountersClose(counters);
+	}
+	free(emissivitySweep);
+	free(emissivitySweepTable);
+	free(emissivitySweepTableDouble);
+
+	free(recordedFrames);
+	frameWriterFree(&frameWriter);
+
+	if (outputRing.header != NULL)
+	{
+		shmRingEnd(&outputRing);
+		shmRingClose(&outputRing);
+	}
+	shmRingClose(&inputRing);
+	framePrefetcherStop(&framePrefetcher);
+	frameReaderClose(&frameReader);
+
+	if (batchReader.failedFileCount > 0)
+	{
+		fprintf(stderr, "%zu recordings of directory '%s' could not be read\n", batchReader.failedFileCount, arguments.rawDataPath);
+	}
+	batchReaderClose(&batchReader);
+
+	if (frameOutputFile != NULL)
+	{
+		if ((frameWriterFlush(&frameOutputWriter) != kCommonConstantReturnTypeSuccess) ||
+			((frameOutputFile != stdout) && (fclose(frameOutputFile) != 0)))
+		{
+			fprintf(stderr, "Error in writing output file '%s'\n", arguments.common.outputFilePath);
+			exit(EXIT_FAILURE);
+		}
+		frameWriterFree(&frameOutputWriter);
+	}
+
+	metricsStop();
+	traceFlush();
+
 	return 0;
 }
 
-static int
-processDataFrame(paramsMLX90640 *  mlx90640Params, size_t line, CommandLineArguments *  arguments)
+static void
+printEmissivitySweep(CommandLineArguments *  arguments, TimingReport *  timing, LatencyHistogram *  latency)
 {
-	int	ret;
-	float	tr;
+	size_t	count = arguments->emissivitySweepCount;
+
+	if (!arguments->common.isOutputJSONMode)
+	{
+		printf("Converting raw data to temperature for %zu emissivities\n", count);
 
-	ret = readUint16DataFromCSV(
-		rawDataFrame,
-		line,
-		kMLX90640ConstantRawFrameBufferSize,
-		arguments->rawDataPath);
+		for (size_t e = 0; e < count; e++)
+		{
+			float *	row = &emissivitySweepTable[e * kMLX90640ConstantFrameBufferSize];
 
-	if (ret <= 0)
+			if (!arguments->printAllTemperatures)
+			{
+				printf("Temperature of pixel %u at emissivity %f: %f Celsius.\n", arguments->pixel, emissivitySweep[e], row[arguments->pixel]);
+				continue;
+			}
+
+			/*
+			 *	One line per emissivity: the emissivity followed by all pixels in row-major order.
+			 */
+			if (arguments->outputFormat == kOutputFormatFixed)
+			{
+				frameWriterAppendFixed(&frameWriter, emissivitySweep[e], 6);
+				for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+				{
+					frameWriterAppendString(&frameWriter, " ");
+					frameWriterAppendFixed(&frameWriter, row[i], 6);
+				}
+				frameWriterAppendString(&frameWriter, "\n");
+				frameWriterFlush(&frameWriter);
+				continue;
+			}
+
+			printf("%f", emissivitySweep[e]);
+			for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+			{
+				printf(" %f", row[i]);
+			}
+			printf("\n");
+		}
+		printf("\n");
+
+		return;
+	}
+
+	if (!arguments->printAllTemperatures)
 	{
-		return -1;
+		/*
+		 *	Gather the selected pixel of every row in place, the table is not used afterwards.
+		 */
+		for (size_t e = 0; e < count; e++)
+		{
+			emissivitySweepTable[e] = emissivitySweepTable[e * kMLX90640ConstantFrameBufferSize + arguments->pixel];
+		}
 	}
 
-	tr = MLX90640_GetTa(rawDataFrame, mlx90640Params) - kMLX90640ConstantTaShift;
-	MLX90640_CalculateTo_UT(
-		rawDataFrame,
-		mlx90640Params,
-		arguments->emissivity,
-		tr,
-		mlx90640To,
-		arguments->modelQuantizationError);
+	JSONvariable	variables[2 + kTimingConstantJSONVariableCount + kLatencyHistogramConstantJSONVariableCount] = {
+		{
+			.variableSymbol = "emissivities",
+			.variableDescription = "Emissivities of the sweep",
+			.values = (JSONvariablePointer) { .asFloat = emissivitySweep },
+			.type = kJSONvariableTypeFloat,
+			.size = count,
+		},
+		{
+			.variableSymbol = "temperatures",
+			.variableDescription = "Temperatures (calibrated) per emissivity",
+			.values = (JSONvariablePointer) { .asFloat = emissivitySweepTable },
+			.type = kJSONvariableTypeFloat,
+			.size = arguments->printAllTemperatures ? count * kMLX90640ConstantFrameBufferSize : count,
+		},
+	};
 
-	return ret;
+	size_t		variableCount = 2;
+
+	variableCount += getReportJSONVariables(timing, latency, &variables[variableCount]);
+	printJSONVariables(variables, variableCount, "MLX90640 Conversion Values.");
+}
+
+static void
+writeTemperatureFrame(const float *  temperatures)
+{
+	for (size_t h = 0; h < kMLX90640ConstantFrameHeight; h++)
+	{
+		for (size_t w = 0; w < kMLX90640ConstantFrameWidth; w++)
+		{
+			frameWriterAppendFixed(&frameWriter, temperatures[h * kMLX90640ConstantFrameWidth + w], 6);
+			frameWriterAppendString(&frameWriter, " ");
+		}
+		frameWriterAppendString(&frameWriter, "\n");
+	}
+
+	if (frameWriterFlush(&frameWriter) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error in writing temperatures\n");
+	}
 }
 
 static void
-MLX90640_CalculateTo_UT(
-	uint16_t *		frameData,
-	const paramsMLX90640 *	params,
-	float			emissivity,
-	float			tr,
-	float *			result,
-	bool			quantizationError)
+setUpFrameOutput(CommandLineArguments *  arguments)
 {
-	float		vdd;
-	float		ta;
-	float		ta4;
-	float		tr4;
-	float		taTr;
-	float		gain;
-	float		irDataCP[2];
-	float		irData;
-	int16_t		tempInt;
-	float		alphaCompensated;
-	uint8_t		mode;
-	int8_t		ilPattern;
-	int8_t		chessPattern;
-	int8_t		pattern;
-	int8_t		conversionPattern;
-	float		Sx;
-	float		To;
-	float		alphaCorrR[4];
-	int8_t		range;
-	uint16_t	subPage;
-	float		ktaScale;
-	float		kvScale;
-	float		alphaScale;
-	float		kta;
-	float		kv;
-
-	subPage = frameData[833];
-	vdd = MLX90640_GetVdd(frameData, params);
-	ta = MLX90640_GetTa(frameData, params);
-
-	ta4 = (ta + 273.15);
-	ta4 = ta4 * ta4;
-	ta4 = ta4 * ta4;
-	tr4 = (tr + 273.15);
-	tr4 = tr4 * tr4;
-	tr4 = tr4 * tr4;
-	taTr = tr4 - (tr4 - ta4) / emissivity;
-
-	ktaScale = POW2(params->ktaScale);
-	kvScale = POW2(params->kvScale);
-	alphaScale = POW2(params->alphaScale);
-
-	alphaCorrR[0] = 1 / (1 + params->ksTo[0] * 40);
-	alphaCorrR[1] = 1;
-	alphaCorrR[2] = (1 + params->ksTo[1] * params->ct[2]);
-	alphaCorrR[3] = alphaCorrR[2] * (1 + params->ksTo[2] * (params->ct[3] - params->ct[2]));
+	frameOutputFile = (strcmp(arguments->common.outputFilePath, "") == 0) ? stdout : fopen(arguments->common.outputFilePath, "wb");
+	if ((frameOutputFile == NULL) ||
+		(frameWriterInit(&frameOutputWriter, frameOutputFile, kFrameWriterConstantDefaultCapacity) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in opening output file '%s'\n", arguments->common.outputFilePath);
+		exit(EXIT_FAILURE);
+	}
+	isFrameOutputEnabled = true;
+
+	if (arguments->outputFormat == kOutputFormatJSONLines)
+	{
+		return;
+	}
+
+	frameWriterAppendUint32(&frameOutputWriter, kFrameWriterConstantFileMagic);
+	frameWriterAppendUint16(&frameOutputWriter, kFrameWriterConstantFileVersion);
+	frameWriterAppendUint16(&frameOutputWriter, arguments->outputFormat);
+	frameWriterAppendUint32(&frameOutputWriter, kMLX90640ConstantFrameBufferSize);
+
+	switch (arguments->outputFormat)
+	{
+		case kOutputFormatInt16:
+			frameWriterAppendUint32(&frameOutputWriter, kFrameWriterConstantRecordHeaderSize + sizeof(mlx90640ToCentiCelsius) + sizeof(saturationBitmap));
+			break;
+
+		case kOutputFormatSparse:
+			frameWriterAppendUint32(&frameOutputWriter, 0);
+			break;
+
+		default:
+			frameWriterAppendUint32(&frameOutputWriter, kFrameWriterConstantRecordHeaderSize + sizeof(mlx90640To));
+			break;
+	}
+}
+
+static void
+writeFrameOutput(CommandLineArguments *  arguments, size_t frameIndex, float ta, float vdd)
+{
+	uint32_t	bits;
+
+	if (arguments->outputFormat == kOutputFormatJSONLines)
+	{
+		frameWriterAppendString(&frameOutputWriter, "{\"frame\":");
+		frameWriterAppendUnsigned(&frameOutputWriter, frameIndex);
+		frameWriterAppendString(&frameOutputWriter, ",\"subpage\":");
+		frameWriterAppendUnsigned(&frameOutputWriter, frameData[kMLX90640ConstantRawFrameBufferSize - 1]);
+		frameWriterAppendString(&frameOutputWriter, ",\"ta\":");
+		frameWriterAppendJSONNumber(&frameOutputWriter, ta, 6);
+		frameWriterAppendString(&frameOutputWriter, ",\"vdd\":");
+		frameWriterAppendJSONNumber(&frameOutputWriter, vdd, 6);
+		frameWriterAppendString(&frameOutputWriter, ",\"temperatures\":[");
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			if (i > 0)
+			{
+				frameWriterAppendString(&frameOutputWriter, ",");
+			}
+			frameWriterAppendJSONNumber(&frameOutputWriter, mlx90640To[i], 6);
+		}
+		frameWriterAppendString(&frameOutputWriter, "]}\n");
+
+		/*
+		 *	Lines are streamed, one write(2) per frame.
+		 */
+		frameWriterFlush(&frameOutputWriter);
+		return;
+	}
+
+	frameWriterAppendUint32(&frameOutputWriter, frameIndex);
+	frameWriterAppendUint32(&frameOutputWriter, frameData[kMLX90640ConstantRawFrameBufferSize - 1]);
+	memcpy(&bits, &ta, sizeof(bits));
+	frameWriterAppendUint32(&frameOutputWriter, bits);
+	memcpy(&bits, &vdd, sizeof(bits));
+	frameWriterAppendUint32(&frameOutputWriter, bits);
+
+	/*
+	 *	Pixels of the other sub-page hold the temperatures of the previous frame.
+	 */
+	if (arguments->outputFormat == kOutputFormatInt16)
+	{
+		frameWriterEncodeCentiCelsius(mlx90640To, kMLX90640ConstantFrameBufferSize, mlx90640ToCentiCelsius, saturationBitmap);
+		frameWriterAppendInt16(&frameOutputWriter, mlx90640ToCentiCelsius, kMLX90640ConstantFrameBufferSize);
+		frameWriterAppendBytes(&frameOutputWriter, saturationBitmap, sizeof(saturationBitmap));
+	}
+	else if (arguments->outputFormat == kOutputFormatSparse)
+	{
+		bool	isKeyframe = (sparseRecordCount % arguments->keyframeInterval) == 0;
+		size_t	valueCount;
+		size_t	runCount = frameWriterEncodeSparse(
+					mlx90640To,
+					sparseReference,
+					kMLX90640ConstantFrameBufferSize,
+					arguments->sparseThreshold,
+					isKeyframe,
+					sparseRuns,
+					sparseValues,
+					&valueCount);
+
+		frameWriterAppendUint16(&frameOutputWriter, isKeyframe ? kFrameWriterConstantSparseFlagKeyframe : 0);
+		frameWriterAppendUint16(&frameOutputWriter, runCount);
+		for (size_t i = 0; i < 2 * runCount; i++)
+		{
+			frameWriterAppendUint16(&frameOutputWriter, sparseRuns[i]);
+		}
+		frameWriterAppendFloat32(&frameOutputWriter, sparseValues, valueCount);
+		sparseRecordCount++;
+	}
+	else
+	{
+		frameWriterAppendFloat32(&frameOutputWriter, mlx90640To, kMLX90640ConstantFrameBufferSize);
+	}
+
+	/*
+	 *	Frames from a pipe or stdin are written as soon as they are converted.
+	 */
+	if (frameReader.isStream)
+	{
+		frameWriterFlush(&frameOutputWriter);
+	}
+}
+
+static void
+setUpReplay(CommandLineArguments *  arguments)
+{
+	if (frameReaderOpen(&frameReader, arguments->rawDataPath, arguments->inputFormat) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error in opening raw frame input '%s'\n", arguments->rawDataPath);
+		exit(EXIT_FAILURE);
+	}
 
 	/*
-	 *	------------------------- Gain calculation -----------------------------------
+	 *	Only complete frames are replayed, since the driver serves the control
+	 *	and status registers from the last two words.
 	 */
+	for (;;)
+	{
+		uint16_t *	frames = realloc(recordedFrames, (recordedFrameCount + 1) * kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t));
+
+		if (frames == NULL)
+		{
+			fprintf(stderr, "Error in allocating replay frames\n");
+			exit(EXIT_FAILURE);
+		}
+		recordedFrames = frames;
+
+		if (frameReaderRead(
+			&frameReader,
+			&recordedFrames[recordedFrameCount * kMLX90640ConstantRawFrameBufferSize],
+			kMLX90640ConstantRawFrameBufferSize) < kMLX90640ConstantRawFrameBufferSize)
+		{
+			break;
+		}
+		recordedFrameCount++;
+	}
+	frameReaderClose(&frameReader);
+
+	if (recordedFrameCount == 0)
+	{
+		fprintf(stderr, "Error in reading sensor raw data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	MLX90640_I2CReplayInit(recordedEEData, recordedFrames, recordedFrameCount, arguments->refreshRateCode >= 0);
+	MLX90640_I2CFreqSet(arguments->i2cFrequency);
+
+	if ((arguments->refreshRateCode >= 0) && (MLX90640_SetRefreshRate(kMLX90640I2CConstantSlaveAddress, arguments->refreshRateCode) != 0))
+	{
+		fprintf(stderr, "Error in setting the refresh rate\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MLX90640_DumpEE(kMLX90640I2CConstantSlaveAddress, eeData) != 0)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void
+setUpSharedMemoryRings(CommandLineArguments *  arguments)
+{
+	if (shmRingOpen(&inputRing, arguments->shmInputName, kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t)) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error in opening shared memory ring '%s' of raw frames\n", arguments->shmInputName);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((strcmp(arguments->shmOutputName, "") != 0) &&
+		(shmRingCreate(
+			&outputRing,
+			arguments->shmOutputName,
+			kFrameWriterConstantRecordHeaderSize + sizeof(mlx90640To),
+			inputRing.header->slotCount) != kCommonConstantReturnTypeSuccess))
+	{
+		fprintf(stderr, "Error in creating shared memory ring '%s' of temperature frames\n", arguments->shmOutputName);
+		exit(EXIT_FAILURE);
+	}
+}
 
-	gain = (float)params->gainEE / (int16_t)frameData[778];
+static void
+publishTemperatureFrame(size_t frameIndex, float ta, float vdd)
+{
+	uint8_t *	slot;
+	uint32_t	header[2] = { frameIndex, frameData[kMLX90640ConstantRawFrameBufferSize - 1] };
+	size_t		attempt = 0;
 
 	/*
-	 *	------------------------- To calculation -------------------------------------
+	 *	A full ring holds back the conversion, and with it the producer of
+	 *	raw frames, until the consumer catches up.
 	 */
-	mode = (frameData[832] & MLX90640_CTRL_MEAS_MODE_MASK) >> 5;
+	while ((slot = shmRingAcquireWrite(&outputRing)) == NULL)
+	{
+		shmRingBackOff(&attempt);
+	}
+
+	memcpy(&slot[0], header, sizeof(header));
+	memcpy(&slot[8], &ta, sizeof(ta));
+	memcpy(&slot[12], &vdd, sizeof(vdd));
+	memcpy(&slot[kFrameWriterConstantRecordHeaderSize], mlx90640To, sizeof(mlx90640To));
+	shmRingCommitWrite(&outputRing);
+}
 
-	irDataCP[0] = (int16_t)frameData[776] * gain;
-	irDataCP[1] = (int16_t)frameData[808] * gain;
+static void
+releaseFrameData(void)
+{
+	if (frameData == rawDataFrame)
+	{
+		return;
+	}
 
-	irDataCP[0] = irDataCP[0] - params->cpOffset[0] * (1 + params->cpKta * (ta - 25)) *
-			(1 + params->cpKv * (vdd - 3.3));
-	if (mode == params->calibrationModeEE)
+	if (inputRing.header != NULL)
 	{
-		irDataCP[1] = irDataCP[1] - params->cpOffset[1] * (1 + params->cpKta * (ta - 25)) *
-				(1 + params->cpKv * (vdd - 3.3));
+		shmRingReleaseRead(&inputRing);
 	}
 	else
 	{
-		irDataCP[1] = irDataCP[1] - (params->cpOffset[1] + params->ilChessC[0]) *
-				(1 + params->cpKta * (ta - 25)) *
-				(1 + params->cpKv * (vdd - 3.3));
+		framePrefetcherRelease(&framePrefetcher);
+	}
+	frameData = rawDataFrame;
+}
+
+static int
+serveConversions(CommandLineArguments *  arguments)
+{
+	CommonConstantReturnType	result;
+	FrameReader			eeDataReader;
+
+	/*
+	 *	Every line of the EEPROM file calibrates one sensor, read in one pass.
+	 */
+	if (frameReaderOpen(&eeDataReader, arguments->eeDataPath, kFrameReaderFormatCSV) != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
 	}
 
-	for (int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
+	for (;;)
 	{
-		ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
-		chessPattern = ilPattern ^ (pixelNumber - (pixelNumber / 2) * 2);
-		conversionPattern = ((pixelNumber + 2) / 4 - (pixelNumber + 3) / 4 +
-					(pixelNumber + 1) / 4 - pixelNumber / 4) *
-					(1 - 2 * ilPattern);
+		ServerSensor *	sensors = realloc(serverSensors, (serverSensorCount + 1) * sizeof(ServerSensor));
 
-		if (mode == 0)
+		if (sensors == NULL)
 		{
-			pattern = ilPattern;
+			fprintf(stderr, "Error in allocating sensor calibrations\n");
+			exit(EXIT_FAILURE);
 		}
-		else
+		serverSensors = sensors;
+
+		if (frameReaderRead(&eeDataReader, eeData, kMLX90640ConstantEEDataBufferSize) < kMLX90640ConstantEEDataBufferSize)
 		{
-			pattern = chessPattern;
+			break;
 		}
 
-		if (pattern == frameData[833])
+		memset(&serverSensors[serverSensorCount], 0, sizeof(ServerSensor));
+		if (MLX90640_ExtractParameters(eeData, &serverSensors[serverSensorCount].params))
 		{
-			/*
-			 *	Signaloid modification: model ADC quantization error using Uniform
-			 *	Dist Original: irData = tempInt * gain;
-			 */
-			tempInt = (int16_t)frameData[pixelNumber];
-			if (quantizationError)
-			{
-				irData = UxHwFloatUniformDist((float)tempInt - 0.5, (float)tempInt + 0.5) * gain;
-			}
-			else
-			{
-				irData = tempInt * gain;
-			}
+			fprintf(stderr, "Error in extracting parameters from EE of sensor %zu\n", serverSensorCount);
+			exit(EXIT_FAILURE);
+		}
+		serverSensorCount++;
+	}
+	frameReaderClose(&eeDataReader);
 
-			kta = params->kta[pixelNumber] / ktaScale;
-			kv = params->kv[pixelNumber] / kvScale;
-			irData = irData - params->offset[pixelNumber] * (1 + kta * (ta - 25)) * (1 + kv * (vdd - 3.3));
+	printf("Converting raw data to temperature for %zu sensors on '%s'\n", serverSensorCount, arguments->serverSocketPath);
+	fflush(stdout);
 
-			if (mode != params->calibrationModeEE)
-			{
-				irData = irData + params->ilChessC[2] * (2 * ilPattern - 1) - params->ilChessC[1] * conversionPattern;
-			}
+	result = serverRun(arguments->serverSocketPath, convertServerFrame, arguments);
 
-			irData = irData - params->tgc * irDataCP[subPage];
-			irData = irData / emissivity;
+	free(serverSensors);
+	metricsStop();
+	traceFlush();
 
-			alphaCompensated = SCALEALPHA * alphaScale / params->alpha[pixelNumber];
-			alphaCompensated = alphaCompensated * (1 + params->KsTa * (ta - 25));
+	return (result == kCommonConstantReturnTypeSuccess) ? 0 : EXIT_FAILURE;
+}
 
-			Sx = alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * taTr);
-			Sx = sqrt(sqrt(Sx)) * params->ksTo[1];
-			To = sqrt(sqrt(irData / (alphaCompensated * (1 - params->ksTo[1] * 273.15) + Sx) + taTr)) - 273.15;
+static bool
+convertServerFrame(void *  context, uint32_t sensorId, uint16_t *  frame, uint8_t *  record)
+{
+	CommandLineArguments *	arguments = context;
+	ServerSensor *		sensor;
+	uint64_t		traceStageBegin = traceBegin();
+	uint32_t		header[2];
+	float			tr;
+	float			ta;
+	float			vdd;
 
-			if (To < params->ct[1])
-			{
-				range = 0;
-			}
-			else if (To < params->ct[2])
-			{
-				range = 1;
-			}
-			else if (To < params->ct[3])
-			{
-				range = 2;
-			}
-			else
+	if (sensorId >= serverSensorCount)
+	{
+		metricsIncrement(kMetricsCounterFramesDropped);
+		return false;
+	}
+	sensor = &serverSensors[sensorId];
+
+	tr = MLX90640_GetTa(frame, &sensor->params) - kMLX90640ConstantTaShift;
+	ta = tr + kMLX90640ConstantTaShift;
+	vdd = MLX90640_GetVdd(frame, &sensor->params);
+	metricsRecordSensor(ta, vdd);
+
+	if (arguments->precision == kMLX90640PrecisionDouble)
+	{
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640ToDouble[i] = sensor->temperatures[i];
+		}
+
+		MLX90640_CalculateTo_UTDouble(
+			frame,
+			&sensor->params,
+			arguments->emissivity,
+			(strcmp(arguments->emissivityMapPath, "") != 0) ? emissivityMap : NULL,
+			tr,
+			mlx90640ToDouble,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			sensor->temperatures[i] = mlx90640ToDouble[i];
+		}
+	}
+	else
+	{
+		MLX90640_CalculateTo_UT(
+			frame,
+			&sensor->params,
+			arguments->emissivity,
+			(strcmp(arguments->emissivityMapPath, "") != 0) ? emissivityMap : NULL,
+			tr,
+			sensor->temperatures,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+	}
+
+	header[0] = sensor->frameCount++;
+	header[1] = frame[kMLX90640ConstantRawFrameBufferSize - 1];
+	memcpy(&record[0], header, sizeof(header));
+	memcpy(&record[8], &ta, sizeof(ta));
+	memcpy(&record[12], &vdd, sizeof(vdd));
+	memcpy(&record[kFrameWriterConstantRecordHeaderSize], sensor->temperatures, sizeof(sensor->temperatures));
+
+	metricsIncrement(kMetricsCounterFramesConverted);
+	traceEnd("convertServerFrame", traceStageBegin, sensorId);
+
+	return true;
+}
+
+static size_t
+getReportJSONVariables(TimingReport *  timing, LatencyHistogram *  latency, JSONvariable *  variables)
+{
+	size_t	count = 0;
+
+	if (timing != NULL)
+	{
+		count += timingGetJSONVariables(timing, &variables[count]);
+	}
+
+	if (latency != NULL)
+	{
+		count += latencyHistogramGetJSONVariables(latency, &variables[count]);
+	}
+
+	return count;
+}
+
+static int
+processDataFrame(
+	paramsMLX90640 *  mlx90640Params,
+	size_t line,
+	CommandLineArguments *  arguments,
+	TimingReport *  timing,
+	PerformanceCounters *  counters,
+	LatencyHistogram *  latency)
+{
+	int		ret;
+	float		tr;
+	uint64_t	frameBegin = ((timing != NULL) || (latency != NULL) || metricsIsEnabled()) ? getMonotonicTimeNanoseconds() : 0;
+	uint64_t	frameEnd;
+	uint64_t	stageBegin;
+	uint64_t	traceFrameBegin = traceBegin();
+	uint64_t	traceStageBegin = traceFrameBegin;
+
+	performanceCountersStart(counters);
+
+	if (inputRing.header != NULL)
+	{
+		size_t	attempt = 0;
+
+		while ((frameData = shmRingAcquireRead(&inputRing)) == NULL)
+		{
+			if (shmRingIsFinished(&inputRing))
 			{
-				range = 3;
+				frameData = rawDataFrame;
+				return -1;
 			}
+			shmRingBackOff(&attempt);
+		}
+		metricsSetQueueDepth(shmRingGetCount(&inputRing));
+
+		/*
+		 *	Waiting for the producer is not part of the latency of the frame.
+		 */
+		frameBegin = (frameBegin != 0) ? getMonotonicTimeNanoseconds() : 0;
+		ret = kMLX90640ConstantRawFrameBufferSize;
+		traceEnd("shmRingAcquireRead", traceStageBegin, line);
+	}
+	else if (arguments->isReplayEnabled)
+	{
+		if (line >= recordedFrameCount)
+		{
+			return -1;
+		}
+
+		if (MLX90640_GetFrameData(kMLX90640I2CConstantSlaveAddress, rawDataFrame) < 0)
+		{
+			performanceCountersStop(counters, kPerformanceCounterScopeParse);
+			metricsIncrement(kMetricsCounterFramesDropped);
+			return 0;
+		}
+		ret = kMLX90640ConstantRawFrameBufferSize;
+		traceEnd("MLX90640_GetFrameData", traceStageBegin, line);
+	}
+	else if (framePrefetcher.isRunning)
+	{
+		/*
+		 *	The reader thread has usually parsed the frame already. Waiting
+		 *	for a pipe or stdin to deliver it is not part of the latency of
+		 *	the frame, waiting for a file is.
+		 */
+		uint16_t *	frame = framePrefetcherAcquire(&framePrefetcher, &ret);
 
-			To = sqrt(sqrt(irData / (alphaCompensated * alphaCorrR[range] * (1 + params->ksTo[range] * (To - params->ct[range]))) + taTr)) - 273.15;
-			result[pixelNumber] = To;
+		frameData = (frame != NULL) ? frame : rawDataFrame;
+		metricsSetQueueDepth(framePrefetcherGetCount(&framePrefetcher));
+		if (frameReader.isStream)
+		{
+			frameBegin = (frameBegin != 0) ? getMonotonicTimeNanoseconds() : 0;
 		}
+		traceEnd("framePrefetcherAcquire", traceStageBegin, line);
+	}
+	else if (batchReader.paths != NULL)
+	{
+		ret = batchReaderRead(&batchReader, rawDataFrame, kMLX90640ConstantRawFrameBufferSize);
+		traceEnd("batchReaderRead", traceStageBegin, line);
 	}
+	else
+	{
+		/*
+		 *	Waiting for a pipe or stdin to deliver the frame is not part of
+		 *	the latency of the frame.
+		 */
+		if (frameReader.isStream)
+		{
+			frameReaderWait(&frameReader);
+			frameBegin = (frameBegin != 0) ? getMonotonicTimeNanoseconds() : 0;
+			traceStageBegin = traceBegin();
+		}
+
+		ret = frameReaderRead(&frameReader, rawDataFrame, kMLX90640ConstantRawFrameBufferSize);
+		traceEnd("frameReaderRead", traceStageBegin, line);
+	}
+
+	stageBegin = recordStage(timing, kTimingStageParse, frameBegin);
+
+	/*
+	 *	A blank line still holds a slot of the prefetcher.
+	 */
+	if (ret <= 0)
+	{
+		releaseFrameData();
+		return -1;
+	}
+
+	performanceCountersStop(counters, kPerformanceCounterScopeParse);
+
+	/*
+	 *	An incomplete line would be converted with the words of the previous frame.
+	 */
+	if (ret < kMLX90640ConstantRawFrameBufferSize)
+	{
+		metricsIncrement(kMetricsCounterParseErrors);
+		metricsIncrement(kMetricsCounterFramesDropped);
+		releaseFrameData();
+		return 0;
+	}
+
+	tr = MLX90640_GetTa(frameData, mlx90640Params) - kMLX90640ConstantTaShift;
+
+	if (metricsIsEnabled())
+	{
+		metricsRecordSensor(tr + kMLX90640ConstantTaShift, MLX90640_GetVdd(frameData, mlx90640Params));
+	}
+
+	stageBegin = recordStage(timing, kTimingStageAmbient, stageBegin);
+	performanceCountersStart(counters);
+	traceStageBegin = traceBegin();
+
+	if ((arguments->emissivitySweepCount > 0) && (arguments->precision == kMLX90640PrecisionDouble))
+	{
+		size_t	count = arguments->emissivitySweepCount * kMLX90640ConstantFrameBufferSize;
+
+		MLX90640_CalculateToSweep_UTDouble(
+			frameData,
+			mlx90640Params,
+			emissivitySweep,
+			arguments->emissivitySweepCount,
+			tr,
+			emissivitySweepTableDouble,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			emissivitySweepTable[i] = emissivitySweepTableDouble[i];
+		}
+	}
+	else if (arguments->emissivitySweepCount > 0)
+	{
+		MLX90640_CalculateToSweep_UT(
+			frameData,
+			mlx90640Params,
+			emissivitySweep,
+			arguments->emissivitySweepCount,
+			tr,
+			emissivitySweepTable,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+	}
+	else if (arguments->precision == kMLX90640PrecisionFixedPoint)
+	{
+		MLX90640_CalculateTo_FixedPoint(frameData, &fixedPointParams, mlx90640ToCentiKelvin);
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640To[i] = (mlx90640ToCentiKelvin[i] == 0) ? NAN : mlx90640ToCentiKelvin[i] / 100.0f - 273.15f;
+		}
+	}
+	else if (arguments->precision == kMLX90640PrecisionDouble)
+	{
+		MLX90640_CalculateTo_UTDouble(
+			frameData,
+			mlx90640Params,
+			arguments->emissivity,
+			(strcmp(arguments->emissivityMapPath, "") != 0) ? emissivityMap : NULL,
+			tr,
+			mlx90640ToDouble,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+
+		for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			mlx90640To[i] = mlx90640ToDouble[i];
+		}
+	}
+	else
+	{
+		MLX90640_CalculateTo_UT(
+			frameData,
+			mlx90640Params,
+			arguments->emissivity,
+			(strcmp(arguments->emissivityMapPath, "") != 0) ? emissivityMap : NULL,
+			tr,
+			mlx90640To,
+			arguments->modelQuantizationError,
+			arguments->rootPrecision);
+	}
+
+	performanceCountersStop(counters, kPerformanceCounterScopeKernel);
+	traceEnd("MLX90640_CalculateTo", traceStageBegin, line);
+	frameEnd = recordStage(timing, kTimingStageKernel, stageBegin);
+	timingRecordFrame(timing, frameBegin, frameEnd);
+	latencyHistogramRecord(latency, frameEnd - frameBegin);
+
+	if (isFrameOutputEnabled)
+	{
+		traceStageBegin = traceBegin();
+		writeFrameOutput(arguments, line, tr + kMLX90640ConstantTaShift, MLX90640_GetVdd(frameData, mlx90640Params));
+		recordStage(timing, kTimingStageOutput, frameEnd);
+		traceEnd("writeFrameOutput", traceStageBegin, line);
+	}
+
+	if (outputRing.header != NULL)
+	{
+		traceStageBegin = traceBegin();
+		publishTemperatureFrame(line, tr + kMLX90640ConstantTaShift, MLX90640_GetVdd(frameData, mlx90640Params));
+		traceEnd("publishTemperatureFrame", traceStageBegin, line);
+	}
+	releaseFrameData();
+	metricsIncrement(kMetricsCounterFramesConverted);
+	traceEnd("processDataFrame", traceFrameBegin, line);
+
+	return ret;
+}
+
+static uint64_t
+recordStage(TimingReport *  timing, TimingStage stage, uint64_t begin)
+{
+	uint64_t	end = timingRecordStage(timing, stage, begin);
+
+	if (begin == 0)
+	{
+		return 0;
+	}
+
+	if (end == 0)
+	{
+		end = getMonotonicTimeNanoseconds();
+	}
+	metricsRecordStage(stage, end - begin);
+
+	return end;
 }
@@ -0,0 +1,375 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "metrics.h"
+#include "utilities.h"
+
+/*
+ *	Gauges of the sensor readings: last, minimum and maximum.
+ */
+typedef struct MetricsRange
+{
+	_Atomic(double)	last;
+	_Atomic(double)	minimum;
+	_Atomic(double)	maximum;
+} MetricsRange;
+
+typedef struct Metrics
+{
+	atomic_uint_fast64_t	counters[kMetricsCounterCount];
+	atomic_uint_fast64_t	stageNanoseconds[kTimingStageCount];
+	atomic_uint_fast64_t	stageCount[kTimingStageCount];
+	atomic_size_t		queueDepth;
+	MetricsRange		ta;
+	MetricsRange		vdd;
+} Metrics;
+
+static const char *	kMetricsCounterNames[kMetricsCounterCount] = {
+	[kMetricsCounterFramesConverted]	= "mlx90640_frames_converted_total",
+	[kMetricsCounterFramesDropped]		= "mlx90640_frames_dropped_total",
+	[kMetricsCounterParseErrors]		= "mlx90640_parse_errors_total",
+};
+
+static const char *	kMetricsCounterHelp[kMetricsCounterCount] = {
+	[kMetricsCounterFramesConverted]	= "Raw frames converted to temperatures.",
+	[kMetricsCounterFramesDropped]		= "Raw frames read or acquired but not converted.",
+	[kMetricsCounterParseErrors]		= "Raw frames with missing words.",
+};
+
+static Metrics		metrics;
+static bool		metricsEnabled;
+static char		metricsPath[kCommonConstantMaxCharsPerFilepath];
+static char		metricsTemporaryPath[kCommonConstantMaxCharsPerFilepath + 8];
+static pthread_t	metricsWriter;
+static pthread_mutex_t	metricsWriterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	metricsWriterCondition;
+static bool		isMetricsWriterStopping;
+
+/**
+ *	@brief	Lower or raise a gauge to `value` if it is below its minimum or above its maximum.
+ *
+ *	@param	range		: Gauges to update.
+ *	@param	value		: New reading.
+ */
+static void	updateRange(MetricsRange *  range, double value);
+
+/**
+ *	@brief	Format all metrics in the Prometheus text exposition format and replace the exposition file.
+ *
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	writeExposition(void);
+
+/**
+ *	@brief	Writer thread: rewrite the exposition file every period until metricsStop().
+ *
+ *	@param	argument	: Unused.
+ *	@return	void *		: NULL.
+ */
+static void *	runWriter(void *  argument);
+
+CommonConstantReturnType
+metricsStart(const char *  path)
+{
+	pthread_condattr_t	conditionAttributes;
+
+	snprintf(metricsPath, sizeof(metricsPath), "%s", path);
+	snprintf(metricsTemporaryPath, sizeof(metricsTemporaryPath), "%s.tmp", path);
+
+	atomic_store(&metrics.ta.minimum, INFINITY);
+	atomic_store(&metrics.ta.maximum, -INFINITY);
+	atomic_store(&metrics.ta.last, NAN);
+	atomic_store(&metrics.vdd.minimum, INFINITY);
+	atomic_store(&metrics.vdd.maximum, -INFINITY);
+	atomic_store(&metrics.vdd.last, NAN);
+
+	/*
+	 *	Fail early on an unwritable path rather than in the writer thread.
+	 */
+	if (writeExposition() != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	pthread_condattr_init(&conditionAttributes);
+	pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&metricsWriterCondition, &conditionAttributes);
+	pthread_condattr_destroy(&conditionAttributes);
+
+	if (pthread_create(&metricsWriter, NULL, runWriter, NULL) != 0)
+	{
+		pthread_cond_destroy(&metricsWriterCondition);
+		return kCommonConstantReturnTypeError;
+	}
+	metricsEnabled = true;
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+void
+metricsStop(void)
+{
+	if (!metricsEnabled)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&metricsWriterMutex);
+	isMetricsWriterStopping = true;
+	pthread_cond_signal(&metricsWriterCondition);
+	pthread_mutex_unlock(&metricsWriterMutex);
+
+	pthread_join(metricsWriter, NULL);
+	pthread_cond_destroy(&metricsWriterCondition);
+	metricsEnabled = false;
+
+	if (writeExposition() != kCommonConstantReturnTypeSuccess)
+	{
+		fprintf(stderr, "Error: Could not write metrics file '%s'.\n", metricsPath);
+	}
+}
+
+bool
+metricsIsEnabled(void)
+{
+	return metricsEnabled;
+}
+
+void
+metricsIncrement(MetricsCounter counter)
+{
+	if (metricsEnabled)
+	{
+		atomic_fetch_add_explicit(&metrics.counters[counter], 1, memory_order_relaxed);
+	}
+}
+
+void
+metricsRecordStage(TimingStage stage, uint64_t nanoseconds)
+{
+	if (metricsEnabled)
+	{
+		atomic_fetch_add_explicit(&metrics.stageNanoseconds[stage], nanoseconds, memory_order_relaxed);
+		atomic_fetch_add_explicit(&metrics.stageCount[stage], 1, memory_order_relaxed);
+	}
+}
+
+void
+metricsSetQueueDepth(size_t depth)
+{
+	if (metricsEnabled)
+	{
+		atomic_store_explicit(&metrics.queueDepth, depth, memory_order_relaxed);
+	}
+}
+
+void
+metricsRecordSensor(double ta, double vdd)
+{
+	if (metricsEnabled)
+	{
+		updateRange(&metrics.ta, ta);
+		updateRange(&metrics.vdd, vdd);
+	}
+}
+
+static void
+updateRange(MetricsRange *  range, double value)
+{
+	double	current;
+
+	atomic_store_explicit(&range->last, value, memory_order_relaxed);
+
+	current = atomic_load_explicit(&range->minimum, memory_order_relaxed);
+	while ((value < current) && !atomic_compare_exchange_weak_explicit(&range->minimum, &current, value, memory_order_relaxed, memory_order_relaxed))
+	{
+	}
+
+	current = atomic_load_explicit(&range->maximum, memory_order_relaxed);
+	while ((value > current) && !atomic_compare_exchange_weak_explicit(&range->maximum, &current, value, memory_order_relaxed, memory_order_relaxed))
+	{
+	}
+}
+
+static CommonConstantReturnType
+writeExposition(void)
+{
+	char		exposition[kMetricsConstantMaxExpositionSize];
+	size_t		length = 0;
+	FILE *		file;
+	const struct
+	{
+		const char *		name;
+		const char *		unit;
+		const char *		help;
+		const MetricsRange *	range;
+	} gauges[] = {
+		{ .name = "mlx90640_ambient_temperature",	.unit = "celsius",	.help = "Ambient temperature of the sensor",	.range = &metrics.ta },
+		{ .name = "mlx90640_supply_voltage",		.unit = "volts",	.help = "Supply voltage of the sensor",		.range = &metrics.vdd },
+	};
+
+	/*
+	 *	The exposition is formatted completely before the file is opened, so
+	 *	a slow disk delays only this thread.
+	 */
+	for (MetricsCounter c = 0; c < kMetricsCounterCount; c++)
+	{
+		length += snprintf(
+				&exposition[length],
+				sizeof(exposition) - length,
+				"# HELP %s %s\n# TYPE %s counter\n%s %" PRIuFAST64 "\n",
+				kMetricsCounterNames[c],
+				kMetricsCounterHelp[c],
+				kMetricsCounterNames[c],
+				kMetricsCounterNames[c],
+				atomic_load_explicit(&metrics.counters[c], memory_order_relaxed));
+	}
+
+	length += snprintf(
+			&exposition[length],
+			sizeof(exposition) - length,
+			"# HELP mlx90640_stage_duration_seconds Time spent in each stage of the conversion.\n"
+			"# TYPE mlx90640_stage_duration_seconds summary\n");
+	for (TimingStage s = 0; s < kTimingStageCount; s++)
+	{
+		length += snprintf(
+				&exposition[length],
+				sizeof(exposition) - length,
+				"mlx90640_stage_duration_seconds_sum{stage=\"%s\"} %.9f\n"
+				"mlx90640_stage_duration_seconds_count{stage=\"%s\"} %" PRIuFAST64 "\n",
+				timingGetStageName(s),
+				atomic_load_explicit(&metrics.stageNanoseconds[s], memory_order_relaxed) * 1e-9,
+				timingGetStageName(s),
+				atomic_load_explicit(&metrics.stageCount[s], memory_order_relaxed));
+	}
+
+	length += snprintf(
+			&exposition[length],
+			sizeof(exposition) - length,
+			"# HELP mlx90640_queue_depth Raw frames waiting to be converted.\n"
+			"# TYPE mlx90640_queue_depth gauge\n"
+			"mlx90640_queue_depth %zu\n",
+			atomic_load_explicit(&metrics.queueDepth, memory_order_relaxed));
+
+	for (size_t g = 0; g < sizeof(gauges) / sizeof(gauges[0]); g++)
+	{
+		/*
+		 *	Prometheus spells infinities and NaN as +Inf, -Inf and NaN,
+		 *	which differ from printf().
+		 */
+		double		values[3] = {
+					atomic_load_explicit(&gauges[g].range->last, memory_order_relaxed),
+					atomic_load_explicit(&gauges[g].range->minimum, memory_order_relaxed),
+					atomic_load_explicit(&gauges[g].range->maximum, memory_order_relaxed),
+				};
+		const char *	suffixes[3] = { "", "_min", "_max" };
+		const char *	helpSuffixes[3] = { ".", ", minimum since start.", ", maximum since start." };
+
+		for (int v = 0; v < 3; v++)
+		{
+			length += snprintf(
+					&exposition[length],
+					sizeof(exposition) - length,
+					"# HELP %s%s_%s %s%s\n# TYPE %s%s_%s gauge\n%s%s_%s ",
+					gauges[g].name, suffixes[v], gauges[g].unit,
+					gauges[g].help, helpSuffixes[v],
+					gauges[g].name, suffixes[v], gauges[g].unit,
+					gauges[g].name, suffixes[v], gauges[g].unit);
+			length += isfinite(values[v])
+					? snprintf(&exposition[length], sizeof(exposition) - length, "%.6f\n", values[v])
+					: snprintf(&exposition[length], sizeof(exposition) - length, "NaN\n");
+		}
+	}
+
+	if (length >= sizeof(exposition))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	file = fopen(metricsTemporaryPath, "w");
+	if (file == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((fwrite(exposition, 1, length, file) != length) | (fclose(file) != 0))
+	{
+		remove(metricsTemporaryPath);
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (rename(metricsTemporaryPath, metricsPath) != 0)
+	{
+		remove(metricsTemporaryPath);
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static void *
+runWriter(void *  argument)
+{
+	struct timespec	deadline;
+
+	(void)argument;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+	pthread_mutex_lock(&metricsWriterMutex);
+	while (!isMetricsWriterStopping)
+	{
+		deadline.tv_sec += kMetricsConstantWritePeriodMilliseconds / 1000;
+		deadline.tv_nsec += (kMetricsConstantWritePeriodMilliseconds % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+
+		while (!isMetricsWriterStopping &&
+			(pthread_cond_timedwait(&metricsWriterCondition, &metricsWriterMutex, &deadline) != ETIMEDOUT))
+		{
+		}
+
+		if (!isMetricsWriterStopping)
+		{
+			pthread_mutex_unlock(&metricsWriterMutex);
+			if (writeExposition() != kCommonConstantReturnTypeSuccess)
+			{
+				fprintf(stderr, "Warning: Could not write metrics file '%s'.\n", metricsPath);
+			}
+			pthread_mutex_lock(&metricsWriterMutex);
+		}
+	}
+	pthread_mutex_unlock(&metricsWriterMutex);
+
+	return NULL;
+}
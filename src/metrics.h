@@ -0,0 +1,96 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "timing.h"
+
+typedef enum
+{
+	kMetricsCounterFramesConverted	= 0,	/* Frames converted to temperatures */
+	kMetricsCounterFramesDropped	= 1,	/* Frames read or acquired but not converted */
+	kMetricsCounterParseErrors	= 2,	/* Raw frames with fewer than kMLX90640ConstantRawFrameBufferSize words */
+	kMetricsCounterCount		= 3,
+} MetricsCounter;
+
+typedef enum
+{
+	kMetricsConstantWritePeriodMilliseconds	= 1000,
+	kMetricsConstantMaxExpositionSize	= 8192,
+} MetricsConstant;
+
+/**
+ *	@brief	Enable metrics and start a thread that rewrites `path` in the Prometheus text exposition
+ *		format every kMetricsConstantWritePeriodMilliseconds. The file is written to a temporary file
+ *		and renamed over `path`, so readers always see a complete exposition. The conversion only
+ *		updates atomic counters and gauges and never waits for the writer.
+ *
+ *	@param	path		: Path of the exposition file, e.g. in the directory of the node exporter textfile collector.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	metricsStart(const char *  path);
+
+/**
+ *	@brief	Stop the writer thread and write the final values.
+ */
+void	metricsStop(void);
+
+/**
+ *	@brief	Whether metrics are enabled, so that callers can skip computing values nobody reads.
+ *
+ *	@return	bool		: true after a successful metricsStart().
+ */
+bool	metricsIsEnabled(void);
+
+/**
+ *	@brief	Increment a counter.
+ *
+ *	@param	counter		: Counter.
+ */
+void	metricsIncrement(MetricsCounter counter);
+
+/**
+ *	@brief	Add the duration of one run of a stage.
+ *
+ *	@param	stage		: Stage.
+ *	@param	nanoseconds	: Duration in nanoseconds.
+ */
+void	metricsRecordStage(TimingStage stage, uint64_t nanoseconds);
+
+/**
+ *	@brief	Set the number of raw frames waiting to be converted.
+ *
+ *	@param	depth		: Number of frames.
+ */
+void	metricsSetQueueDepth(size_t depth);
+
+/**
+ *	@brief	Update the last, minimum and maximum ambient temperature and supply voltage of the sensor.
+ *
+ *	@param	ta		: Ambient temperature in Celsius.
+ *	@param	vdd		: Supply voltage in Volt.
+ */
+void	metricsRecordSensor(double ta, double vdd);
@@ -0,0 +1,473 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+/*
+ *	Kernel template, included by mlx90640-conversion.c once per arithmetic type. The includer
+ *	defines:
+ *
+ *		MLX90640_REAL			: arithmetic type (float or double)
+ *		MLX90640_LITERAL(x)		: floating-point literal of type MLX90640_REAL
+ *		MLX90640_SQRT			: square root of type MLX90640_REAL
+ *		MLX90640_UNIFORM_DIST		: uniform distribution constructor of type MLX90640_REAL
+ *		MLX90640_TEMPLATE(name)		: name of an instantiated function or type
+ *
+ *	All literals go through MLX90640_LITERAL so that the float instantiation is not silently
+ *	promoted to double.
+ */
+
+typedef struct MLX90640_TEMPLATE(MLX90640FrameConstants)
+{
+	MLX90640_REAL	vdd;
+	MLX90640_REAL	ta;
+	MLX90640_REAL	ta4;
+	MLX90640_REAL	tr4;
+	MLX90640_REAL	gain;
+	MLX90640_REAL	irDataCP[2];
+	MLX90640_REAL	alphaCorrR[4];
+	MLX90640_REAL	ktaScale;
+	MLX90640_REAL	kvScale;
+	MLX90640_REAL	alphaScale;
+	uint8_t		mode;
+	uint16_t	subPage;
+} MLX90640_TEMPLATE(MLX90640FrameConstants);
+
+static void
+MLX90640_TEMPLATE(MLX90640_CalculateFrameConstants_UT)(
+	uint16_t *					frameData,
+	const paramsMLX90640 *				params,
+	MLX90640_REAL					tr,
+	MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants)
+{
+	MLX90640_REAL	ta;
+	MLX90640_REAL	vdd;
+	MLX90640_REAL	gain;
+
+	constants->subPage = frameData[833];
+	constants->vdd = vdd = MLX90640_GetVdd(frameData, params);
+	constants->ta = ta = MLX90640_GetTa(frameData, params);
+
+	constants->ta4 = (ta + MLX90640_LITERAL(273.15));
+	constants->ta4 = constants->ta4 * constants->ta4;
+	constants->ta4 = constants->ta4 * constants->ta4;
+	constants->tr4 = (tr + MLX90640_LITERAL(273.15));
+	constants->tr4 = constants->tr4 * constants->tr4;
+	constants->tr4 = constants->tr4 * constants->tr4;
+
+	constants->ktaScale = POW2(params->ktaScale);
+	constants->kvScale = POW2(params->kvScale);
+	constants->alphaScale = POW2(params->alphaScale);
+
+	constants->alphaCorrR[0] = 1 / (1 + params->ksTo[0] * 40);
+	constants->alphaCorrR[1] = 1;
+	constants->alphaCorrR[2] = (1 + params->ksTo[1] * params->ct[2]);
+	constants->alphaCorrR[3] = constants->alphaCorrR[2] * (1 + params->ksTo[2] * (params->ct[3] - params->ct[2]));
+
+	/*
+	 *	------------------------- Gain calculation -----------------------------------
+	 */
+
+	constants->gain = gain = (MLX90640_REAL)params->gainEE / (int16_t)frameData[778];
+
+	/*
+	 *	------------------------- To calculation -------------------------------------
+	 */
+	constants->mode = (frameData[832] & MLX90640_CTRL_MEAS_MODE_MASK) >> 5;
+
+	constants->irDataCP[0] = (int16_t)frameData[776] * gain;
+	constants->irDataCP[1] = (int16_t)frameData[808] * gain;
+
+	constants->irDataCP[0] = constants->irDataCP[0] - params->cpOffset[0] * (1 + params->cpKta * (ta - 25)) *
+			(1 + params->cpKv * (vdd - MLX90640_LITERAL(3.3)));
+	if (constants->mode == params->calibrationModeEE)
+	{
+		constants->irDataCP[1] = constants->irDataCP[1] - params->cpOffset[1] * (1 + params->cpKta * (ta - 25)) *
+				(1 + params->cpKv * (vdd - MLX90640_LITERAL(3.3)));
+	}
+	else
+	{
+		constants->irDataCP[1] = constants->irDataCP[1] - (params->cpOffset[1] + params->ilChessC[0]) *
+				(1 + params->cpKta * (ta - 25)) *
+				(1 + params->cpKv * (vdd - MLX90640_LITERAL(3.3)));
+	}
+}
+
+static inline bool
+MLX90640_TEMPLATE(MLX90640_CalculatePixelIrData_UT)(
+	uint16_t *						frameData,
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	int							pixelNumber,
+	bool							quantizationError,
+	MLX90640_REAL *						irDataResult,
+	MLX90640_REAL *						alphaCompensatedResult)
+{
+	MLX90640_REAL	ta = constants->ta;
+	MLX90640_REAL	vdd = constants->vdd;
+	MLX90640_REAL	irData;
+	int16_t		tempInt;
+	MLX90640_REAL	alphaCompensated;
+	int8_t		ilPattern;
+	int8_t		chessPattern;
+	int8_t		pattern;
+	int8_t		conversionPattern;
+	MLX90640_REAL	kta;
+	MLX90640_REAL	kv;
+
+	ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
+	chessPattern = ilPattern ^ (pixelNumber - (pixelNumber / 2) * 2);
+	conversionPattern = ((pixelNumber + 2) / 4 - (pixelNumber + 3) / 4 +
+				(pixelNumber + 1) / 4 - pixelNumber / 4) *
+				(1 - 2 * ilPattern);
+
+	if (constants->mode == 0)
+	{
+		pattern = ilPattern;
+	}
+	else
+	{
+		pattern = chessPattern;
+	}
+
+	if (pattern != frameData[833])
+	{
+		return false;
+	}
+
+	/*
+	 *	Signaloid modification: model ADC quantization error using Uniform
+	 *	Dist Original: irData = tempInt * gain;
+	 */
+	tempInt = (int16_t)frameData[pixelNumber];
+	if (quantizationError)
+	{
+		irData = MLX90640_UNIFORM_DIST((MLX90640_REAL)tempInt - MLX90640_LITERAL(0.5), (MLX90640_REAL)tempInt + MLX90640_LITERAL(0.5)) * constants->gain;
+	}
+	else
+	{
+		irData = tempInt * constants->gain;
+	}
+
+	kta = params->kta[pixelNumber] / constants->ktaScale;
+	kv = params->kv[pixelNumber] / constants->kvScale;
+	irData = irData - params->offset[pixelNumber] * (1 + kta * (ta - 25)) * (1 + kv * (vdd - MLX90640_LITERAL(3.3)));
+
+	if (constants->mode != params->calibrationModeEE)
+	{
+		irData = irData + params->ilChessC[2] * (2 * ilPattern - 1) - params->ilChessC[1] * conversionPattern;
+	}
+
+	irData = irData - params->tgc * constants->irDataCP[constants->subPage];
+
+	alphaCompensated = (MLX90640_REAL)SCALEALPHA * constants->alphaScale / params->alpha[pixelNumber];
+	alphaCompensated = alphaCompensated * (1 + params->KsTa * (ta - 25));
+
+	*irDataResult = irData;
+	*alphaCompensatedResult = alphaCompensated;
+
+	return true;
+}
+
+/*
+ *	The fourth root, the per-pixel tail and the pixel loop are inlined into one copy per
+ *	root precision, so the precision is a constant in the loops instead of a per-pixel branch.
+ *	The fast precision has its own vectorized tail, MLX90640_CalculatePixelsToFast().
+ */
+static inline __attribute__((always_inline)) MLX90640_REAL
+MLX90640_TEMPLATE(MLX90640_FourthRoot)(MLX90640_REAL x, MLX90640RootPrecision rootPrecision)
+{
+	if (rootPrecision == kMLX90640RootPrecisionFloat)
+	{
+		return sqrtf(sqrtf((float)x));
+	}
+
+	return MLX90640_SQRT(MLX90640_SQRT(x));
+}
+
+static inline __attribute__((always_inline)) MLX90640_REAL
+MLX90640_TEMPLATE(MLX90640_CalculatePixelTo_UT)(
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	MLX90640_REAL						irData,
+	MLX90640_REAL						alphaCompensated,
+	MLX90640_REAL						taTr,
+	MLX90640RootPrecision					rootPrecision)
+{
+	MLX90640_REAL	Sx;
+	MLX90640_REAL	To;
+	int8_t		range;
+
+	Sx = alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * taTr);
+	Sx = MLX90640_TEMPLATE(MLX90640_FourthRoot)(Sx, rootPrecision) * params->ksTo[1];
+	To = MLX90640_TEMPLATE(MLX90640_FourthRoot)(irData / (alphaCompensated * (1 - params->ksTo[1] * MLX90640_LITERAL(273.15)) + Sx) + taTr, rootPrecision) - MLX90640_LITERAL(273.15);
+
+	if (To < params->ct[1])
+	{
+		range = 0;
+	}
+	else if (To < params->ct[2])
+	{
+		range = 1;
+	}
+	else if (To < params->ct[3])
+	{
+		range = 2;
+	}
+	else
+	{
+		range = 3;
+	}
+
+	To = MLX90640_TEMPLATE(MLX90640_FourthRoot)(irData / (alphaCompensated * constants->alphaCorrR[range] * (1 + params->ksTo[range] * (To - params->ct[range]))) + taTr, rootPrecision) - MLX90640_LITERAL(273.15);
+
+	return To;
+}
+
+/*
+ *	Gather the pixels of the sub-page into contiguous arrays, padded with harmless values to
+ *	a whole number of blocks for MLX90640_CalculatePixelsToFast(). Returns the padded count.
+ */
+static size_t
+MLX90640_TEMPLATE(MLX90640_GatherPixels_UT)(
+	uint16_t *						frameData,
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	bool							quantizationError,
+	MLX90640_REAL *						irData,
+	MLX90640_REAL *						alphaCompensated,
+	int *							pixelNumbers,
+	size_t *						pixelCount)
+{
+	size_t	count = 0;
+	size_t	paddedCount;
+
+	for (int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
+	{
+		if (MLX90640_TEMPLATE(MLX90640_CalculatePixelIrData_UT)(frameData, params, constants, pixelNumber, quantizationError, &irData[count], &alphaCompensated[count]))
+		{
+			pixelNumbers[count++] = pixelNumber;
+		}
+	}
+
+	paddedCount = (count + kMLX90640ConstantRootBlockSize - 1) / kMLX90640ConstantRootBlockSize * kMLX90640ConstantRootBlockSize;
+	for (size_t i = count; i < paddedCount; i++)
+	{
+		irData[i] = 0;
+		alphaCompensated[i] = 1;
+	}
+	*pixelCount = count;
+
+	return paddedCount;
+}
+
+static void
+MLX90640_TEMPLATE(MLX90640_CalculateToFast_UT)(
+	uint16_t *						frameData,
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	MLX90640_REAL						emissivity,
+	const float *						emissivityMap,
+	MLX90640_REAL *						result,
+	bool							quantizationError)
+{
+	static _Alignas(kMLX90640ConstantCacheLineSize) MLX90640_REAL	irData[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) MLX90640_REAL	alphaCompensated[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		scaledIrData[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		alphaCompensatedFloat[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		taTr[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		to[kMLX90640ConstantFrameBufferSize];
+	static int							pixelNumbers[kMLX90640ConstantFrameBufferSize];
+	float								alphaCorrR[4] = { constants->alphaCorrR[0], constants->alphaCorrR[1], constants->alphaCorrR[2], constants->alphaCorrR[3] };
+	size_t								pixelCount;
+	size_t								paddedCount;
+
+	paddedCount = MLX90640_TEMPLATE(MLX90640_GatherPixels_UT)(frameData, params, constants, quantizationError, irData, alphaCompensated, pixelNumbers, &pixelCount);
+
+	for (size_t i = 0; i < paddedCount; i++)
+	{
+		MLX90640_REAL	pixelEmissivity = ((emissivityMap != NULL) && (i < pixelCount)) ? emissivityMap[pixelNumbers[i]] : emissivity;
+
+		scaledIrData[i] = irData[i] / pixelEmissivity;
+		alphaCompensatedFloat[i] = alphaCompensated[i];
+		taTr[i] = constants->tr4 - (constants->tr4 - constants->ta4) / pixelEmissivity;
+	}
+
+	MLX90640_CalculatePixelsToFast(params, alphaCorrR, scaledIrData, alphaCompensatedFloat, taTr, paddedCount, to);
+
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		result[pixelNumbers[i]] = to[i];
+	}
+}
+
+static inline __attribute__((always_inline)) void
+MLX90640_TEMPLATE(MLX90640_CalculatePixels_UT)(
+	uint16_t *						frameData,
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	MLX90640_REAL						emissivity,
+	const float *						emissivityMap,
+	MLX90640_REAL *						result,
+	bool							quantizationError,
+	MLX90640RootPrecision					rootPrecision)
+{
+	MLX90640_REAL	taTr = constants->tr4 - (constants->tr4 - constants->ta4) / emissivity;
+	MLX90640_REAL	irData;
+	MLX90640_REAL	alphaCompensated;
+
+	for (int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
+	{
+		if (!MLX90640_TEMPLATE(MLX90640_CalculatePixelIrData_UT)(frameData, params, constants, pixelNumber, quantizationError, &irData, &alphaCompensated))
+		{
+			continue;
+		}
+
+		if (emissivityMap != NULL)
+		{
+			emissivity = emissivityMap[pixelNumber];
+			taTr = constants->tr4 - (constants->tr4 - constants->ta4) / emissivity;
+		}
+
+		result[pixelNumber] = MLX90640_TEMPLATE(MLX90640_CalculatePixelTo_UT)(params, constants, irData / emissivity, alphaCompensated, taTr, rootPrecision);
+	}
+}
+
+void
+MLX90640_TEMPLATE(MLX90640_CalculateTo_UT)(
+	uint16_t *		frameData,
+	const paramsMLX90640 *	params,
+	MLX90640_REAL		emissivity,
+	const float *		emissivityMap,
+	MLX90640_REAL		tr,
+	MLX90640_REAL *		result,
+	bool			quantizationError,
+	MLX90640RootPrecision	rootPrecision)
+{
+	MLX90640_TEMPLATE(MLX90640FrameConstants)	constants;
+
+	MLX90640_TEMPLATE(MLX90640_CalculateFrameConstants_UT)(frameData, params, tr, &constants);
+
+	switch (rootPrecision)
+	{
+		case kMLX90640RootPrecisionFast:
+			MLX90640_TEMPLATE(MLX90640_CalculateToFast_UT)(frameData, params, &constants, emissivity, emissivityMap, result, quantizationError);
+			break;
+
+		case kMLX90640RootPrecisionFloat:
+			MLX90640_TEMPLATE(MLX90640_CalculatePixels_UT)(frameData, params, &constants, emissivity, emissivityMap, result, quantizationError, kMLX90640RootPrecisionFloat);
+			break;
+
+		default:
+			MLX90640_TEMPLATE(MLX90640_CalculatePixels_UT)(frameData, params, &constants, emissivity, emissivityMap, result, quantizationError, kMLX90640RootPrecisionExact);
+			break;
+	}
+}
+
+static inline __attribute__((always_inline)) void
+MLX90640_TEMPLATE(MLX90640_CalculateSweepRow_UT)(
+	const paramsMLX90640 *					params,
+	const MLX90640_TEMPLATE(MLX90640FrameConstants) *	constants,
+	const MLX90640_REAL *					irData,
+	const MLX90640_REAL *					alphaCompensated,
+	const int *						pixelNumbers,
+	size_t							pixelCount,
+	MLX90640_REAL						emissivity,
+	MLX90640_REAL *						row,
+	MLX90640RootPrecision					rootPrecision)
+{
+	MLX90640_REAL	taTr = constants->tr4 - (constants->tr4 - constants->ta4) / emissivity;
+
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		row[pixelNumbers[i]] = MLX90640_TEMPLATE(MLX90640_CalculatePixelTo_UT)(params, constants, irData[i] / emissivity, alphaCompensated[i], taTr, rootPrecision);
+	}
+}
+
+void
+MLX90640_TEMPLATE(MLX90640_CalculateToSweep_UT)(
+	uint16_t *		frameData,
+	const paramsMLX90640 *	params,
+	const float *		emissivities,
+	size_t			emissivityCount,
+	MLX90640_REAL		tr,
+	MLX90640_REAL *		result,
+	bool			quantizationError,
+	MLX90640RootPrecision	rootPrecision)
+{
+	static _Alignas(kMLX90640ConstantCacheLineSize) MLX90640_REAL	irData[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) MLX90640_REAL	alphaCompensated[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		scaledIrData[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		alphaCompensatedFloat[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		taTr[kMLX90640ConstantFrameBufferSize];
+	static _Alignas(kMLX90640ConstantCacheLineSize) float		to[kMLX90640ConstantFrameBufferSize];
+	static int							pixelNumbers[kMLX90640ConstantFrameBufferSize];
+	MLX90640_TEMPLATE(MLX90640FrameConstants)			constants;
+	float								alphaCorrR[4];
+	size_t								pixelCount;
+	size_t								paddedCount;
+
+	MLX90640_TEMPLATE(MLX90640_CalculateFrameConstants_UT)(frameData, params, tr, &constants);
+	for (size_t r = 0; r < 4; r++)
+	{
+		alphaCorrR[r] = constants.alphaCorrR[r];
+	}
+
+	/*
+	 *	Everything up to the emissivity division is computed once per pixel of
+	 *	the sub-page ...
+	 */
+	paddedCount = MLX90640_TEMPLATE(MLX90640_GatherPixels_UT)(frameData, params, &constants, quantizationError, irData, alphaCompensated, pixelNumbers, &pixelCount);
+
+	/*
+	 *	... and only the emissivity-dependent tail is evaluated per emissivity,
+	 *	filling one row of the [emissivity][pixel] table at a time.
+	 */
+	for (size_t e = 0; e < emissivityCount; e++)
+	{
+		MLX90640_REAL	emissivity = emissivities[e];
+		MLX90640_REAL *	row = &result[e * kMLX90640ConstantFrameBufferSize];
+
+		switch (rootPrecision)
+		{
+			case kMLX90640RootPrecisionFast:
+				for (size_t i = 0; i < paddedCount; i++)
+				{
+					scaledIrData[i] = irData[i] / emissivity;
+					alphaCompensatedFloat[i] = alphaCompensated[i];
+					taTr[i] = constants.tr4 - (constants.tr4 - constants.ta4) / emissivity;
+				}
+				MLX90640_CalculatePixelsToFast(params, alphaCorrR, scaledIrData, alphaCompensatedFloat, taTr, paddedCount, to);
+				for (size_t i = 0; i < pixelCount; i++)
+				{
+					row[pixelNumbers[i]] = to[i];
+				}
+				break;
+
+			case kMLX90640RootPrecisionFloat:
+				MLX90640_TEMPLATE(MLX90640_CalculateSweepRow_UT)(params, &constants, irData, alphaCompensated, pixelNumbers, pixelCount, emissivity, row, kMLX90640RootPrecisionFloat);
+				break;
+
+			default:
+				MLX90640_TEMPLATE(MLX90640_CalculateSweepRow_UT)(params, &constants, irData, alphaCompensated, pixelNumbers, pixelCount, emissivity, row, kMLX90640RootPrecisionExact);
+				break;
+		}
+	}
+}
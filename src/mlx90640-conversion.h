@@ -0,0 +1,91 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <MLX90640_API.h>
+
+/*
+ *	Precision of the fourth roots in the To calculation. The fast tier reinterprets the float
+ *	bits for its initial estimate and therefore only gives meaningful results on particle
+ *	values (e.g., with `-q` and a scalar emissivity).
+ */
+typedef enum
+{
+	kMLX90640RootPrecisionExact		= 0, /* sqrt(sqrt(x)) in the arithmetic type of the kernel */
+	kMLX90640RootPrecisionFloat		= 1, /* sqrtf(sqrtf(x)), within 0.1 mK of double */
+	kMLX90640RootPrecisionFast		= 2, /* rsqrt estimate and two Newton steps, within 4.5e-5 relative (35 mK at 527 Celsius) */
+} MLX90640RootPrecision;
+
+/*
+ *	Arithmetic type of the To calculation.
+ */
+typedef enum
+{
+	kMLX90640PrecisionFloat			= 0,
+	kMLX90640PrecisionDouble		= 1,
+	kMLX90640PrecisionFixedPoint		= 2, /* integer kernel of mlx90640-fixed-point.h */
+} MLX90640Precision;
+
+/**
+ *	@brief	Calculate calibrated temperatures frame in single precision. Modified from Melexis original library
+ *		to model ADC quantization error.
+ *
+ *	@param	frameData		: Raw data frame from MLX90640.
+ *	@param	params			: Parameters of MLX90640 sensor.
+ *	@param	emissivity		: Emissivity of the measured object.
+ *	@param	emissivityMap		: Per-pixel emissivities overriding `emissivity`, or NULL.
+ *	@param	tr			: Reflected temperature based on the sensor ambient temperature.
+ *	@param	result			: Pointer to float array for storing calibrated temperatures.
+ *	@param	quantizationError	: Enable modeling of ADC quantization error.
+ *	@param	rootPrecision		: Precision of the fourth roots.
+ */
+void	MLX90640_CalculateTo_UT(uint16_t *  frameData, const paramsMLX90640 *  params, float emissivity, const float *  emissivityMap, float tr, float *  result, bool quantizationError, MLX90640RootPrecision rootPrecision);
+
+/**
+ *	@brief	Double precision version of `MLX90640_CalculateTo_UT`.
+ */
+void	MLX90640_CalculateTo_UTDouble(uint16_t *  frameData, const paramsMLX90640 *  params, double emissivity, const float *  emissivityMap, double tr, double *  result, bool quantizationError, MLX90640RootPrecision rootPrecision);
+
+/**
+ *	@brief	Calculate calibrated temperatures frame for many emissivities in one pass, in single precision. The
+ *		emissivity-independent part of the calculation is done once per pixel, the rest once per pixel and
+ *		emissivity.
+ *
+ *	@param	frameData		: Raw data frame from MLX90640.
+ *	@param	params			: Parameters of MLX90640 sensor.
+ *	@param	emissivities		: Emissivities of the measured object.
+ *	@param	emissivityCount		: Number of emissivities.
+ *	@param	tr			: Reflected temperature based on the sensor ambient temperature.
+ *	@param	result			: Pointer to [emissivityCount][kMLX90640ConstantFrameBufferSize] float table for storing calibrated temperatures.
+ *	@param	quantizationError	: Enable modeling of ADC quantization error.
+ *	@param	rootPrecision		: Precision of the fourth roots.
+ */
+void	MLX90640_CalculateToSweep_UT(uint16_t *  frameData, const paramsMLX90640 *  params, const float *  emissivities, size_t emissivityCount, float tr, float *  result, bool quantizationError, MLX90640RootPrecision rootPrecision);
+
+/**
+ *	@brief	Double precision version of `MLX90640_CalculateToSweep_UT`.
+ */
+void	MLX90640_CalculateToSweep_UTDouble(uint16_t *  frameData, const paramsMLX90640 *  params, const float *  emissivities, size_t emissivityCount, double tr, double *  result, bool quantizationError, MLX90640RootPrecision rootPrecision);
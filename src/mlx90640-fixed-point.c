@@ -0,0 +1,404 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <MLX90640_API.h>
+#include "mlx90640-fixed-point.h"
+
+/*
+ *	sqrt((i + 0.5) / 256) * 2^16 for i in [64, 255], the top byte of a normalized radicand.
+ */
+static const uint16_t	kSquareRootSeeds[192] = {
+	0x8080, 0x817E, 0x827A, 0x8374, 0x846C, 0x8563, 0x8658, 0x874B, 0x883C, 0x892C, 0x8A1A, 0x8B06,
+	0x8BF1, 0x8CDB, 0x8DC3, 0x8EA9, 0x8F8E, 0x9072, 0x9154, 0x9235, 0x9314, 0x93F2, 0x94CF, 0x95AB,
+	0x9685, 0x975E, 0x9836, 0x990D, 0x99E2, 0x9AB6, 0x9B8A, 0x9C5C, 0x9D2D, 0x9DFD, 0x9ECC, 0x9F99,
+	0xA066, 0xA132, 0xA1FD, 0xA2C7, 0xA38F, 0xA457, 0xA51E, 0xA5E4, 0xA6A9, 0xA76D, 0xA831, 0xA8F3,
+	0xA9B5, 0xAA75, 0xAB35, 0xABF4, 0xACB2, 0xAD70, 0xAE2C, 0xAEE8, 0xAFA3, 0xB05D, 0xB116, 0xB1CF,
+	0xB287, 0xB33E, 0xB3F5, 0xB4AA, 0xB55F, 0xB614, 0xB6C7, 0xB77A, 0xB82D, 0xB8DE, 0xB98F, 0xBA3F,
+	0xBAEF, 0xBB9E, 0xBC4C, 0xBCFA, 0xBDA7, 0xBE53, 0xBEFF, 0xBFAB, 0xC055, 0xC0FF, 0xC1A9, 0xC252,
+	0xC2FA, 0xC3A2, 0xC449, 0xC4F0, 0xC596, 0xC63B, 0xC6E0, 0xC785, 0xC829, 0xC8CC, 0xC96F, 0xCA12,
+	0xCAB4, 0xCB55, 0xCBF6, 0xCC96, 0xCD36, 0xCDD6, 0xCE75, 0xCF13, 0xCFB1, 0xD04F, 0xD0EC, 0xD188,
+	0xD225, 0xD2C0, 0xD35C, 0xD3F6, 0xD491, 0xD52B, 0xD5C4, 0xD65D, 0xD6F6, 0xD78E, 0xD826, 0xD8BD,
+	0xD954, 0xD9EB, 0xDA81, 0xDB17, 0xDBAC, 0xDC41, 0xDCD6, 0xDD6A, 0xDDFE, 0xDE91, 0xDF24, 0xDFB7,
+	0xE049, 0xE0DB, 0xE16D, 0xE1FE, 0xE28F, 0xE31F, 0xE3AF, 0xE43F, 0xE4CE, 0xE55D, 0xE5EC, 0xE67A,
+	0xE708, 0xE796, 0xE823, 0xE8B0, 0xE93D, 0xE9C9, 0xEA55, 0xEAE1, 0xEB6C, 0xEBF7, 0xEC82, 0xED0C,
+	0xED96, 0xEE20, 0xEEAA, 0xEF33, 0xEFBC, 0xF044, 0xF0CC, 0xF154, 0xF1DC, 0xF263, 0xF2EA, 0xF371,
+	0xF3F8, 0xF47E, 0xF504, 0xF589, 0xF60F, 0xF694, 0xF718, 0xF79D, 0xF821, 0xF8A5, 0xF929, 0xF9AC,
+	0xFA2F, 0xFAB2, 0xFB35, 0xFBB7, 0xFC39, 0xFCBB, 0xFD3C, 0xFDBD, 0xFE3E, 0xFEBF, 0xFF40, 0xFFC0,
+};
+
+/*
+ *	273.15 and 298.15 (25 Celsius) Kelvin in Q16.
+ */
+static const int64_t	kZeroCelsiusQ16 = 17901158;
+static const int64_t	kTwentyFiveCelsiusQ16 = 19539558;
+
+/**
+ *	@brief	Mark every pixel of a frame as invalid, for frames whose words would divide by zero or
+ *		name a sub-page other than 0 or 1.
+ *
+ *	@param	result		: Temperatures of the frame in centi-Kelvin.
+ */
+static void
+invalidateFrame(uint16_t *  result)
+{
+	memset(result, 0, 768 * sizeof(uint16_t));
+}
+
+/**
+ *	@brief	Round a real to the nearest Q-format integer.
+ *
+ *	@param	value		: Real value.
+ *	@param	fractionBits	: Number of fractional bits.
+ *	@return	int32_t		: round(value * 2^fractionBits).
+ */
+static int32_t
+toFixedPoint(double value, int fractionBits)
+{
+	return (int32_t)lround(ldexp(value, fractionBits));
+}
+
+/**
+ *	@brief	Integer square root of a 64-bit integer, seeded from `kSquareRootSeeds` and refined with Newton steps.
+ *
+ *	@param	x		: Radicand.
+ *	@return	uint64_t	: floor(sqrt(x)).
+ */
+static uint64_t
+squareRoot(uint64_t x)
+{
+	int		shift;
+	uint64_t	normalized;
+	uint64_t	y;
+
+	if (x == 0)
+	{
+		return 0;
+	}
+
+	/*
+	 *	Normalize by an even shift so that the top byte is in [64, 255]. The
+	 *	seed is then accurate to 2^-9 and two Newton steps reach 2^-39.
+	 */
+	shift = __builtin_clzll(x) & ~1;
+	normalized = x << shift;
+	y = (uint64_t)kSquareRootSeeds[(normalized >> 56) - 64] << 16;
+	y = (y + normalized / y) >> 1;
+	y = (y + normalized / y) >> 1;
+
+	/*
+	 *	After the first step y >= sqrt(normalized), so only correct downwards.
+	 */
+	if (y > 0xFFFFFFFFULL)
+	{
+		y = 0xFFFFFFFFULL;
+	}
+	while (y * y > normalized)
+	{
+		y--;
+	}
+
+	return y >> (shift / 2);
+}
+
+uint32_t
+MLX90640_FixedPointFourthRootQ20(uint64_t x)
+{
+	const uint64_t	kMaxRadicand = (1ULL << 42) - 1;
+
+	if (x > kMaxRadicand)
+	{
+		x = kMaxRadicand;
+	}
+
+	/*
+	 *	sqrt(x << 20) = sqrt(x) * 2^10 < 2^31, and sqrt(that << 30) = x^(1/4) * 2^20.
+	 */
+	return (uint32_t)squareRoot(squareRoot(x << 20) << 30);
+}
+
+/**
+ *	@brief	Fourth power of a temperature.
+ *
+ *	@param	kelvinQ16	: Temperature in Kelvin, Q16.
+ *	@return	int64_t		: Fourth power in K^4.
+ */
+static int64_t
+fourthPower(int64_t kelvinQ16)
+{
+	int64_t	squareQ8 = (kelvinQ16 * kelvinQ16) >> 24;
+
+	return (squareQ8 * squareQ8) >> 16;
+}
+
+void
+MLX90640_PrepareFixedPointParameters(const paramsMLX90640 *  params, float emissivity, float trShift, MLX90640FixedPointParams *  fixedPointParams)
+{
+	double	alphaCorrR[4];
+
+	fixedPointParams->kVdd = params->kVdd;
+	fixedPointParams->vdd25 = params->vdd25;
+	fixedPointParams->kvPTATQ12 = toFixedPoint(params->KvPTAT, 12);
+	fixedPointParams->ktPTATQ3 = toFixedPoint(params->KtPTAT, 3);
+	fixedPointParams->vPTAT25 = params->vPTAT25;
+	fixedPointParams->alphaPTATQ2 = toFixedPoint(params->alphaPTAT, 2);
+	fixedPointParams->resolutionEE = params->resolutionEE;
+
+	fixedPointParams->gainEE = params->gainEE;
+	fixedPointParams->tgcQ16 = toFixedPoint(params->tgc, 16);
+	fixedPointParams->cpKtaQ30 = toFixedPoint(params->cpKta, 30);
+	fixedPointParams->cpKvQ30 = toFixedPoint(params->cpKv, 30);
+	fixedPointParams->ksTaQ30 = toFixedPoint(params->KsTa, 30);
+	fixedPointParams->cpOffset[0] = params->cpOffset[0];
+	fixedPointParams->cpOffset[1] = params->cpOffset[1];
+	fixedPointParams->ilChessC0Q16 = toFixedPoint(params->ilChessC[0], 16);
+	fixedPointParams->calibrationModeEE = params->calibrationModeEE;
+	fixedPointParams->ktaScale = params->ktaScale;
+	fixedPointParams->kvScale = params->kvScale;
+
+	alphaCorrR[0] = 1 / (1 + params->ksTo[0] * 40);
+	alphaCorrR[1] = 1;
+	alphaCorrR[2] = (1 + params->ksTo[1] * params->ct[2]);
+	alphaCorrR[3] = alphaCorrR[2] * (1 + params->ksTo[2] * (params->ct[3] - params->ct[2]));
+
+	for (int range = 0; range < 4; range++)
+	{
+		fixedPointParams->ksToQ30[range] = toFixedPoint(params->ksTo[range], 30);
+		fixedPointParams->ct[range] = params->ct[range];
+		fixedPointParams->alphaCorrRQ16[range] = toFixedPoint(alphaCorrR[range], 16);
+	}
+
+	/*
+	 *	The pixel sensitivity is SCALEALPHA * 2^alphaScale / alpha[i], so its inverse
+	 *	is alpha[i] times a per-device factor, in K^4 per ADC count.
+	 */
+	fixedPointParams->alphaFactorQ16 = toFixedPoint(1 / (SCALEALPHA * ldexp(1, params->alphaScale)), 16);
+
+	fixedPointParams->inverseEmissivityQ16 = toFixedPoint(1 / emissivity, 16);
+	fixedPointParams->trShiftQ16 = toFixedPoint(trShift, 16);
+
+	for (int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
+	{
+		int	ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
+		int	conversionPattern = ((pixelNumber + 2) / 4 - (pixelNumber + 3) / 4 +
+						(pixelNumber + 1) / 4 - pixelNumber / 4) *
+						(1 - 2 * ilPattern);
+
+		fixedPointParams->offset[pixelNumber] = params->offset[pixelNumber];
+		fixedPointParams->kta[pixelNumber] = params->kta[pixelNumber];
+		fixedPointParams->kv[pixelNumber] = params->kv[pixelNumber];
+		fixedPointParams->alpha[pixelNumber] = params->alpha[pixelNumber];
+		fixedPointParams->chessCorrectionQ16[pixelNumber] = toFixedPoint(
+			params->ilChessC[2] * (2 * ilPattern - 1) - params->ilChessC[1] * conversionPattern,
+			16);
+	}
+}
+
+void
+MLX90640_CalculateTo_FixedPoint(uint16_t *  frameData, const MLX90640FixedPointParams *  fixedPointParams, uint16_t *  result)
+{
+	const MLX90640FixedPointParams *	p = fixedPointParams;
+	int					resolutionShift;
+	int64_t					vddNumeratorQ16;
+	int64_t					dVddQ16;
+	int64_t					ptat;
+	int64_t					ptatDivisor;
+	int64_t					vddDivisorQ28;
+	int64_t					ksTaDivisorQ16;
+	int64_t					ptatArtQ8;
+	int64_t					dTaQ16;
+	int64_t					ta4;
+	int64_t					tr4;
+	int64_t					taTr;
+	int64_t					gainQ16;
+	int64_t					cpTermQ16;
+	int64_t					irDataCPQ16[2];
+	int64_t					tgcCPQ16;
+	int64_t					alphaFactorQ16;
+	uint8_t					mode;
+	uint16_t				subPage;
+
+	subPage = frameData[833];
+	mode = (frameData[832] & MLX90640_CTRL_MEAS_MODE_MASK) >> 5;
+
+	/*
+	 *	------------------------- Vdd and Ta -----------------------------------------
+	 *
+	 *	Vdd - 3.3 = (2^(resolutionEE - resolutionRAM) * vdd - vdd25) / kVdd.
+	 */
+	resolutionShift = p->resolutionEE - ((frameData[832] & 0x0C00) >> 10);
+	vddNumeratorQ16 = (int64_t)(int16_t)frameData[810] * 65536;
+	vddNumeratorQ16 = (resolutionShift >= 0) ? (vddNumeratorQ16 << resolutionShift) : (vddNumeratorQ16 >> -resolutionShift);
+	dVddQ16 = (vddNumeratorQ16 - (int64_t)p->vdd25 * 65536) / p->kVdd;
+
+	/*
+	 *	Ta - 25 = (ptat / (ptat * alphaPTAT + vbe) * 2^18 / (1 + KvPTAT * (Vdd - 3.3)) - vPTAT25) / KtPTAT.
+	 */
+	ptat = (int16_t)frameData[800];
+	ptatDivisor = ptat * p->alphaPTATQ2 + 4 * (int64_t)(int16_t)frameData[768];
+	vddDivisorQ28 = (1 << 28) + p->kvPTATQ12 * dVddQ16;
+
+	/*
+	 *	A corrupt frame must not end the run: where the float kernels produce NaN,
+	 *	every pixel of the frame is marked invalid.
+	 */
+	if ((subPage > 1) || (ptatDivisor == 0) || (vddDivisorQ28 == 0) || ((int16_t)frameData[778] == 0))
+	{
+		invalidateFrame(result);
+		return;
+	}
+
+	ptatArtQ8 = (ptat << 28) / ptatDivisor;
+	ptatArtQ8 = (ptatArtQ8 << 28) / vddDivisorQ28;
+	dTaQ16 = ((ptatArtQ8 - ((int64_t)p->vPTAT25 << 8)) << 11) / p->ktPTATQ3;
+
+	ta4 = fourthPower(kTwentyFiveCelsiusQ16 + dTaQ16);
+	tr4 = fourthPower(kTwentyFiveCelsiusQ16 + dTaQ16 - p->trShiftQ16);
+	taTr = tr4 - (((tr4 - ta4) * p->inverseEmissivityQ16) >> 16);
+
+	/*
+	 *	------------------------- Gain and compensation pixels ----------------------
+	 */
+	gainQ16 = ((int64_t)p->gainEE << 16) / (int16_t)frameData[778];
+
+	cpTermQ16 = (((65536 + ((p->cpKtaQ30 * dTaQ16) >> 30)) * (65536 + ((p->cpKvQ30 * dVddQ16) >> 30))) >> 16);
+	irDataCPQ16[0] = (int16_t)frameData[776] * gainQ16 - p->cpOffset[0] * cpTermQ16;
+	if (mode == p->calibrationModeEE)
+	{
+		irDataCPQ16[1] = (int16_t)frameData[808] * gainQ16 - p->cpOffset[1] * cpTermQ16;
+	}
+	else
+	{
+		irDataCPQ16[1] = (int16_t)frameData[808] * gainQ16 - ((((int64_t)p->cpOffset[1] << 16) + p->ilChessC0Q16) * cpTermQ16 >> 16);
+	}
+	tgcCPQ16 = (p->tgcQ16 * irDataCPQ16[subPage]) >> 16;
+
+	/*
+	 *	Per-frame factor of the inverse pixel sensitivity, including the emissivity:
+	 *	1 / (alphaCompensated * emissivity) = alpha[i] * alphaFactor / ((1 + KsTa * (Ta - 25)) * emissivity).
+	 */
+	ksTaDivisorQ16 = 65536 + ((p->ksTaQ30 * dTaQ16) >> 30);
+	if (ksTaDivisorQ16 == 0)
+	{
+		invalidateFrame(result);
+		return;
+	}
+	alphaFactorQ16 = ((int64_t)p->alphaFactorQ16 << 16) / ksTaDivisorQ16;
+	alphaFactorQ16 = (alphaFactorQ16 * p->inverseEmissivityQ16) >> 16;
+
+	/*
+	 *	------------------------- To calculation -------------------------------------
+	 */
+	for (int pixelNumber = 0; pixelNumber < 768; pixelNumber++)
+	{
+		int		ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
+		int		chessPattern = ilPattern ^ (pixelNumber - (pixelNumber / 2) * 2);
+		int		pattern = (mode == 0) ? ilPattern : chessPattern;
+		int64_t		ktaTermQ16;
+		int64_t		kvTermQ16;
+		int64_t		irDataQ16;
+		int64_t		inverseAlpha;
+		int64_t		signal;
+		int64_t		radicand;
+		int64_t		kelvinQ20;
+		int64_t		toQ16;
+		int64_t		denominatorQ16;
+		int		range;
+
+		if (pattern != frameData[833])
+		{
+			continue;
+		}
+
+		ktaTermQ16 = 65536 + ((p->kta[pixelNumber] * dTaQ16) >> p->ktaScale);
+		kvTermQ16 = 65536 + ((p->kv[pixelNumber] * dVddQ16) >> p->kvScale);
+
+		irDataQ16 = (int16_t)frameData[pixelNumber] * gainQ16;
+		irDataQ16 -= ((p->offset[pixelNumber] * ktaTermQ16) * kvTermQ16) >> 16;
+		if (mode != p->calibrationModeEE)
+		{
+			irDataQ16 += p->chessCorrectionQ16[pixelNumber];
+		}
+		irDataQ16 -= tgcCPQ16;
+
+		/*
+		 *	signal = irData / (alphaCompensated * emissivity), in K^4.
+		 */
+		inverseAlpha = (p->alpha[pixelNumber] * alphaFactorQ16) >> 16;
+		signal = (irDataQ16 * inverseAlpha) >> 16;
+
+		/*
+		 *	First estimate, as in the Melexis library with Sx = ksTo[1] * alphaCompensated * Tp,
+		 *	where Tp = (signal + taTr)^(1/4).
+		 */
+		radicand = signal + taTr;
+		if (radicand <= 0)
+		{
+			result[pixelNumber] = 0;
+			continue;
+		}
+		kelvinQ20 = MLX90640_FixedPointFourthRootQ20(radicand);
+		denominatorQ16 = 65536 + ((p->ksToQ30[1] * ((kelvinQ20 >> 4) - kZeroCelsiusQ16)) >> 30);
+
+		radicand = (denominatorQ16 != 0) ? (signal << 16) / denominatorQ16 + taTr : 0;
+		if (radicand <= 0)
+		{
+			result[pixelNumber] = 0;
+			continue;
+		}
+		toQ16 = (MLX90640_FixedPointFourthRootQ20(radicand) >> 4) - kZeroCelsiusQ16;
+
+		if (toQ16 < ((int64_t)p->ct[1] << 16))
+		{
+			range = 0;
+		}
+		else if (toQ16 < ((int64_t)p->ct[2] << 16))
+		{
+			range = 1;
+		}
+		else if (toQ16 < ((int64_t)p->ct[3] << 16))
+		{
+			range = 2;
+		}
+		else
+		{
+			range = 3;
+		}
+
+		denominatorQ16 = (p->alphaCorrRQ16[range] * (65536 + ((p->ksToQ30[range] * (toQ16 - ((int64_t)p->ct[range] << 16))) >> 30))) >> 16;
+		radicand = (denominatorQ16 != 0) ? (signal << 16) / denominatorQ16 + taTr : 0;
+		if (radicand <= 0)
+		{
+			result[pixelNumber] = 0;
+			continue;
+		}
+
+		/*
+		 *	Round to centi-Kelvin and saturate to the uint16 range (655.35 K).
+		 */
+		kelvinQ20 = ((int64_t)MLX90640_FixedPointFourthRootQ20(radicand) * 100 + (1 << 19)) >> 20;
+		result[pixelNumber] = (kelvinQ20 > UINT16_MAX) ? UINT16_MAX : (uint16_t)kelvinQ20;
+	}
+}
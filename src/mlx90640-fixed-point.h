@@ -0,0 +1,110 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <MLX90640_API.h>
+
+/*
+ *	Fixed-point To calculation for cores without (fast) floating point. The calibration is
+ *	converted once into the integer tables and Q-format scalars below; every per-frame step
+ *	from the raw frame to the temperatures (Vdd, Ta, gain, compensation, fourth roots) then
+ *	runs in 32- and 64-bit integer arithmetic. Suffixes give the number of fractional bits,
+ *	e.g., `Q16` is value * 2^16. The kernel does not model the ADC quantization error.
+ */
+typedef struct MLX90640FixedPointParams
+{
+	/*
+	 *	Vdd and Ta.
+	 */
+	int16_t		kVdd;
+	int16_t		vdd25;
+	int32_t		kvPTATQ12;
+	int32_t		ktPTATQ3;
+	int32_t		vPTAT25;
+	int32_t		alphaPTATQ2;
+	uint8_t		resolutionEE;
+
+	/*
+	 *	Per-device scalars.
+	 */
+	int16_t		gainEE;
+	int32_t		tgcQ16;
+	int32_t		cpKtaQ30;
+	int32_t		cpKvQ30;
+	int32_t		ksTaQ30;
+	int32_t		ksToQ30[4];
+	int16_t		ct[4];
+	int32_t		alphaCorrRQ16[4];
+	int32_t		alphaFactorQ16;
+	int32_t		cpOffset[2];
+	int32_t		ilChessC0Q16;
+	uint8_t		calibrationModeEE;
+	uint8_t		ktaScale;
+	uint8_t		kvScale;
+
+	/*
+	 *	Scene.
+	 */
+	int32_t		inverseEmissivityQ16;
+	int32_t		trShiftQ16;
+
+	/*
+	 *	Per-pixel tables. `chessCorrectionQ16` holds the interleaved/chess pattern correction,
+	 *	applied when the frame's measurement mode differs from the calibration mode.
+	 */
+	int16_t		offset[768];
+	int8_t		kta[768];
+	int8_t		kv[768];
+	uint16_t	alpha[768];
+	int32_t		chessCorrectionQ16[768];
+} MLX90640FixedPointParams;
+
+/**
+ *	@brief	Prepare the fixed-point calibration tables. This is the only step that uses floating point
+ *		and runs once per calibration.
+ *
+ *	@param	params			: Parameters of MLX90640 sensor.
+ *	@param	emissivity		: Emissivity of the measured object.
+ *	@param	trShift			: Difference between the ambient and the reflected temperature, in Celsius.
+ *	@param	fixedPointParams	: Pointer to struct for storing the fixed-point calibration.
+ */
+void	MLX90640_PrepareFixedPointParameters(const paramsMLX90640 *  params, float emissivity, float trShift, MLX90640FixedPointParams *  fixedPointParams);
+
+/**
+ *	@brief	Calculate calibrated temperatures frame in fixed-point integer arithmetic.
+ *
+ *	@param	frameData		: Raw data frame from MLX90640.
+ *	@param	fixedPointParams	: Fixed-point calibration of MLX90640 sensor.
+ *	@param	result			: Pointer to array for storing temperatures in centi-Kelvin (0 for pixels with an invalid signal, and for every pixel of a frame with a zero divisor or an invalid sub-page).
+ */
+void	MLX90640_CalculateTo_FixedPoint(uint16_t *  frameData, const MLX90640FixedPointParams *  fixedPointParams, uint16_t *  result);
+
+/**
+ *	@brief	Fourth root of a 64-bit integer, from two table-seeded Newton square roots.
+ *
+ *	@param	x			: Radicand, below 2^42.
+ *	@return	uint32_t		: x^(1/4) * 2^20, within 1e-5 of the exact root for x >= 10^8 (100 K in K^4).
+ */
+uint32_t	MLX90640_FixedPointFourthRootQ20(uint64_t x);
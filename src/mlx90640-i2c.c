@@ -21,8 +21,84 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "mlx90640-i2c.h"
+#include "utilities.h"
+
+/*
+ *	Status register bits: the sub-page of the last measurement, the data-ready flag and the
+ *	host-controlled overwrite and start-of-measurement flags.
+ */
+static const uint16_t	kStatusSubPageMask = 0x0007;
+static const uint16_t	kStatusDataReady = 0x0008;
+static const uint16_t	kStatusHostMask = 0x0030;
+
+/*
+ *	Bits on the bus per transaction: start, address and register address, repeated start and
+ *	address for reads, stop, plus 18 bits per data word including acknowledgements.
+ */
+static const uint64_t	kReadOverheadBits = 39;
+static const uint64_t	kWriteOverheadBits = 29;
+static const uint64_t	kBitsPerWord = 18;
+
+static const uint16_t *	replayEEData;
+static const uint16_t *	replayFrames;
+static size_t		replayFrameCount;
+static size_t		replayNextFrame;
+static bool		replayEmulateRefreshRate;
+static uint16_t		replayRAM[kMLX90640I2CConstantRAMWords];
+static uint16_t		replayStatusRegister;
+static uint16_t		replayControlRegister;
+static uint64_t		replayFrameReadyNanoseconds;
+static uint64_t		replayBusFrequencyHz;
+static uint64_t		replayBusFreeNanoseconds;
+
+/**
+ *	@brief	Duration of one sub-page measurement at the refresh rate selected in the control register.
+ *
+ *	@return	uint64_t		: refresh period in nanoseconds
+ */
+static uint64_t	refreshPeriodNanoseconds(void);
+
+/**
+ *	@brief	Latch the next recorded frame into RAM if the host has acknowledged the previous one and,
+ *		when emulating the refresh rate, its measurement time has elapsed.
+ */
+static void	latchFrameIfReady(void);
+
+/**
+ *	@brief	Occupy the emulated bus for `bits` bit periods and wait until the transfer completes.
+ *
+ *	@param	bits			: bit periods of the transaction
+ */
+static void	occupyBus(uint64_t bits);
+
+/**
+ *	@brief	Read one word of the emulated device memory map.
+ *
+ *	@param	address			: word address
+ *	@return	uint16_t		: value at `address`, 0 outside the EEPROM, RAM and registers
+ */
+static uint16_t	readWord(uint16_t address);
+
+void
+MLX90640_I2CReplayInit(const uint16_t *  eeData, const uint16_t *  frames, size_t frameCount, bool emulateRefreshRate)
+{
+	replayEEData = eeData;
+	replayFrames = frames;
+	replayFrameCount = frameCount;
+	replayNextFrame = 0;
+	replayEmulateRefreshRate = emulateRefreshRate;
+	replayStatusRegister = 0;
+	replayControlRegister = frames[kMLX90640I2CConstantFrameWords - 2];
+	replayFrameReadyNanoseconds = getMonotonicTimeNanoseconds();
+	replayBusFreeNanoseconds = 0;
+	memset(replayRAM, 0, sizeof(replayRAM));
+}
 
 void
 MLX90640_I2CInit(void)
@@ -42,16 +118,144 @@ MLX90640_I2CRead(
 	uint16_t	nMemAddressRead,
 	uint16_t *	data)
 {
+	if (replayFrames == NULL)
+	{
+		return 0;
+	}
+
+	occupyBus(kReadOverheadBits + kBitsPerWord * nMemAddressRead);
+
+	for (uint32_t i = 0; i < nMemAddressRead; i++)
+	{
+		data[i] = readWord(startAddress + i);
+	}
+
 	return 0;
 }
 
 int
 MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
 {
+	if (replayFrames == NULL)
+	{
+		return 0;
+	}
+
+	occupyBus(kWriteOverheadBits + kBitsPerWord);
+
+	if (writeAddress == kMLX90640I2CConstantStatusRegister)
+	{
+		/*
+		 *	The host acknowledges a frame by writing the data-ready bit as zero.
+		 */
+		replayStatusRegister = (replayStatusRegister & (kStatusSubPageMask | (data & kStatusDataReady))) | (data & kStatusHostMask);
+	}
+	else if (writeAddress == kMLX90640I2CConstantControlRegister)
+	{
+		replayControlRegister = data;
+	}
+
 	return 0;
 }
 
 void
 MLX90640_I2CFreqSet(int freq)
 {
+	replayBusFrequencyHz = (freq > 0) ? (uint64_t)freq * 1000 : 0;
+}
+
+static uint64_t
+refreshPeriodNanoseconds(void)
+{
+	/*
+	 *	Refresh rate code 0 is 0.5 Hz, every further code doubles the rate up to 64 Hz.
+	 */
+	unsigned int	code = (replayControlRegister >> 7) & 0x7;
+
+	return (code == 0) ? 2000000000ULL : (1000000000ULL >> (code - 1));
+}
+
+static void
+latchFrameIfReady(void)
+{
+	const uint16_t *	frame;
+	uint64_t		now;
+
+	if ((replayStatusRegister & kStatusDataReady) != 0)
+	{
+		return;
+	}
+
+	now = getMonotonicTimeNanoseconds();
+	if (replayEmulateRefreshRate && (now < replayFrameReadyNanoseconds))
+	{
+		return;
+	}
+
+	frame = &replayFrames[replayNextFrame * kMLX90640I2CConstantFrameWords];
+	memcpy(replayRAM, frame, sizeof(replayRAM));
+	replayStatusRegister = (replayStatusRegister & kStatusHostMask) | kStatusDataReady | (frame[kMLX90640I2CConstantFrameWords - 1] & kStatusSubPageMask);
+	replayNextFrame = (replayNextFrame + 1) % replayFrameCount;
+
+	/*
+	 *	The next measurement completes one period after this one, or immediately if the host
+	 *	has fallen behind. Recorded frames are never skipped.
+	 */
+	replayFrameReadyNanoseconds += refreshPeriodNanoseconds();
+	if (replayFrameReadyNanoseconds < now)
+	{
+		replayFrameReadyNanoseconds = now;
+	}
+}
+
+static void
+occupyBus(uint64_t bits)
+{
+	struct timespec	deadline;
+	uint64_t	now;
+
+	if (replayBusFrequencyHz == 0)
+	{
+		return;
+	}
+
+	now = getMonotonicTimeNanoseconds();
+	if (replayBusFreeNanoseconds < now)
+	{
+		replayBusFreeNanoseconds = now;
+	}
+	replayBusFreeNanoseconds += (bits * 1000000000ULL) / replayBusFrequencyHz;
+
+	deadline.tv_sec = replayBusFreeNanoseconds / 1000000000ULL;
+	deadline.tv_nsec = replayBusFreeNanoseconds % 1000000000ULL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+	{
+	}
+}
+
+static uint16_t
+readWord(uint16_t address)
+{
+	if ((address >= kMLX90640I2CConstantEEPROMStart) && (address < kMLX90640I2CConstantEEPROMStart + kMLX90640I2CConstantEEPROMWords))
+	{
+		return replayEEData[address - kMLX90640I2CConstantEEPROMStart];
+	}
+
+	if ((address >= kMLX90640I2CConstantRAMStart) && (address < kMLX90640I2CConstantRAMStart + kMLX90640I2CConstantRAMWords))
+	{
+		return replayRAM[address - kMLX90640I2CConstantRAMStart];
+	}
+
+	if (address == kMLX90640I2CConstantStatusRegister)
+	{
+		latchFrameIfReady();
+		return replayStatusRegister;
+	}
+
+	if (address == kMLX90640I2CConstantControlRegister)
+	{
+		return replayControlRegister;
+	}
+
+	return 0;
 }
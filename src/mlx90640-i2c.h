@@ -0,0 +1,55 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+	kMLX90640I2CConstantSlaveAddress	= 0x33,
+	kMLX90640I2CConstantStatusRegister	= 0x8000,
+	kMLX90640I2CConstantControlRegister	= 0x800D,
+	kMLX90640I2CConstantRAMStart		= 0x0400,
+	kMLX90640I2CConstantEEPROMStart		= 0x2400,
+	kMLX90640I2CConstantRAMWords		= 832,
+	kMLX90640I2CConstantEEPROMWords		= 832,
+	kMLX90640I2CConstantFrameWords		= 834,
+} MLX90640I2CConstant;
+
+/**
+ *	@brief	Set up the replay driver behind `MLX90640_I2CRead` and `MLX90640_I2CWrite`. EEPROM reads
+ *		are served from `eeData`, RAM reads from the recorded frames in turn, wrapping around after
+ *		the last one. The control register starts out as recorded in the first frame. The first
+ *		frame is available (data-ready bit of the status register) immediately, every further one
+ *		as soon as the previous one was acknowledged or, if `emulateRefreshRate` is set, one period
+ *		of the refresh rate selected in the control register later. The driver keeps
+ *		pointers to `eeData` and `frames`, which must outlive it.
+ *
+ *	@param	eeData			: EEPROM contents (kMLX90640I2CConstantEEPROMWords values)
+ *	@param	frames			: Recorded raw frames (kMLX90640I2CConstantFrameWords values each)
+ *	@param	frameCount		: Number of recorded frames, at least one
+ *	@param	emulateRefreshRate	: Pace frames at the refresh rate selected in the control register
+ */
+void	MLX90640_I2CReplayInit(const uint16_t *  eeData, const uint16_t *  frames, size_t frameCount, bool emulateRefreshRate);
@@ -0,0 +1,257 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "performance-counters.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *	kPerformanceCounterNames[kPerformanceCounterCount] = {
+	[kPerformanceCounterCycles]		= "cycles",
+	[kPerformanceCounterInstructions]	= "instructions",
+	[kPerformanceCounterL1DMisses]		= "L1D misses",
+	[kPerformanceCounterLLCMisses]		= "LLC misses",
+	[kPerformanceCounterBranchMisses]	= "branch misses",
+};
+
+static const char *	kPerformanceCounterScopeNames[kPerformanceCounterScopeCount] = {
+	[kPerformanceCounterScopeParse]		= "parse",
+	[kPerformanceCounterScopeKernel]	= "kernel",
+};
+
+/**
+ *	@brief	Read the current value of every open counter of the group.
+ *
+ *	@param	counters	: Counters.
+ *	@param	values		: Destination of kPerformanceCounterCount values, indexed by PerformanceCounter.
+ *	@return	bool		: true if successful.
+ */
+static bool	readCounters(PerformanceCounters *  counters, uint64_t *  values);
+
+#if defined(__linux__)
+bool
+performanceCountersOpen(PerformanceCounters *  counters)
+{
+	static const struct
+	{
+		uint32_t	type;
+		uint64_t	config;
+	} kEvents[kPerformanceCounterCount] = {
+		[kPerformanceCounterCycles]		= { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		[kPerformanceCounterInstructions]	= { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		[kPerformanceCounterL1DMisses]		= { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		[kPerformanceCounterLLCMisses]		= { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		[kPerformanceCounterBranchMisses]	= { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	};
+
+	memset(counters, 0, sizeof(*counters));
+	counters->groupFd = -1;
+
+	for (size_t c = 0; c < kPerformanceCounterCount; c++)
+	{
+		struct perf_event_attr	attributes;
+
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = kEvents[c].type;
+		attributes.config = kEvents[c].config;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attributes.disabled = (counters->groupFd == -1);
+
+		counters->fds[c] = syscall(SYS_perf_event_open, &attributes, 0, -1, counters->groupFd, 0);
+		if (counters->fds[c] < 0)
+		{
+			counters->fds[c] = -1;
+			continue;
+		}
+
+		if (counters->groupFd == -1)
+		{
+			counters->groupFd = counters->fds[c];
+		}
+		counters->openCount++;
+	}
+
+	if (counters->groupFd == -1)
+	{
+		return false;
+	}
+
+	ioctl(counters->groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(counters->groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+	return true;
+}
+
+static bool
+readCounters(PerformanceCounters *  counters, uint64_t *  values)
+{
+	/*
+	 *	PERF_FORMAT_GROUP layout: number of events, time enabled, time running,
+	 *	then one value per event in the order the events were opened.
+	 */
+	uint64_t	buffer[3 + kPerformanceCounterCount];
+	size_t		next = 0;
+
+	if (read(counters->groupFd, buffer, sizeof(buffer)) < (ssize_t)((3 + counters->openCount) * sizeof(uint64_t)))
+	{
+		return false;
+	}
+
+	if (buffer[2] < buffer[1])
+	{
+		counters->isMultiplexed = true;
+	}
+
+	for (size_t c = 0; c < kPerformanceCounterCount; c++)
+	{
+		values[c] = (counters->fds[c] != -1) ? buffer[3 + next++] : 0;
+	}
+
+	return true;
+}
+
+void
+performanceCountersClose(PerformanceCounters *  counters)
+{
+	for (size_t c = 0; c < kPerformanceCounterCount; c++)
+	{
+		if (counters->fds[c] != -1)
+		{
+			close(counters->fds[c]);
+			counters->fds[c] = -1;
+		}
+	}
+	counters->groupFd = -1;
+}
+#else
+bool
+performanceCountersOpen(PerformanceCounters *  counters)
+{
+	memset(counters, 0, sizeof(*counters));
+	counters->groupFd = -1;
+	for (size_t c = 0; c < kPerformanceCounterCount; c++)
+	{
+		counters->fds[c] = -1;
+	}
+
+	return false;
+}
+
+static bool
+readCounters(PerformanceCounters *  counters, uint64_t *  values)
+{
+	return false;
+}
+
+void
+performanceCountersClose(PerformanceCounters *  counters)
+{
+}
+#endif
+
+void
+performanceCountersStart(PerformanceCounters *  counters)
+{
+	if ((counters == NULL) || (counters->groupFd == -1))
+	{
+		return;
+	}
+
+	readCounters(counters, counters->startValues);
+}
+
+void
+performanceCountersStop(PerformanceCounters *  counters, PerformanceCounterScope scope)
+{
+	uint64_t	values[kPerformanceCounterCount];
+
+	if ((counters == NULL) || (counters->groupFd == -1) || !readCounters(counters, values))
+	{
+		return;
+	}
+
+	for (size_t c = 0; c < kPerformanceCounterCount; c++)
+	{
+		counters->counts[scope][c] += values[c] - counters->startValues[c];
+	}
+	counters->frameCounts[scope]++;
+}
+
+void
+performanceCountersPrint(const PerformanceCounters *  counters, size_t pixelsPerFrame)
+{
+	if (counters->groupFd == -1)
+	{
+		printf("Performance counters: not available (perf_event_open failed, see /proc/sys/kernel/perf_event_paranoid).\n");
+		return;
+	}
+
+	printf("Performance counters (user space):\n");
+	printf("\t%-8s %-14s %16s %16s %12s\n", "stage", "event", "total", "per frame", "per pixel");
+	for (size_t s = 0; s < kPerformanceCounterScopeCount; s++)
+	{
+		size_t	frames = counters->frameCounts[s];
+
+		for (size_t c = 0; c < kPerformanceCounterCount; c++)
+		{
+			if (counters->fds[c] == -1)
+			{
+				printf("\t%-8s %-14s %16s %16s %12s\n", kPerformanceCounterScopeNames[s], kPerformanceCounterNames[c], "n/a", "n/a", "n/a");
+				continue;
+			}
+
+			printf(
+				"\t%-8s %-14s %16" PRIu64 " %16.1f %12.2f\n",
+				kPerformanceCounterScopeNames[s],
+				kPerformanceCounterNames[c],
+				counters->counts[s][c],
+				(frames > 0) ? (double)counters->counts[s][c] / frames : 0.0,
+				(frames > 0) ? (double)counters->counts[s][c] / (frames * pixelsPerFrame) : 0.0);
+		}
+
+		if ((counters->fds[kPerformanceCounterCycles] != -1) && (counters->fds[kPerformanceCounterInstructions] != -1) &&
+			(counters->counts[s][kPerformanceCounterCycles] > 0))
+		{
+			printf(
+				"\t%-8s %-14s %16.2f\n",
+				kPerformanceCounterScopeNames[s],
+				"IPC",
+				(double)counters->counts[s][kPerformanceCounterInstructions] / counters->counts[s][kPerformanceCounterCycles]);
+		}
+	}
+
+	if (counters->isMultiplexed)
+	{
+		printf("\tThe counters were multiplexed with other users of the PMU, counts are lower bounds.\n");
+	}
+}
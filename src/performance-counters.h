@@ -0,0 +1,101 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *	Hardware events counted around the instrumented stages.
+ */
+typedef enum
+{
+	kPerformanceCounterCycles		= 0,
+	kPerformanceCounterInstructions		= 1,
+	kPerformanceCounterL1DMisses		= 2,
+	kPerformanceCounterLLCMisses		= 3,
+	kPerformanceCounterBranchMisses		= 4,
+	kPerformanceCounterCount		= 5,
+} PerformanceCounter;
+
+/*
+ *	Stages the counts are charged to.
+ */
+typedef enum
+{
+	kPerformanceCounterScopeParse		= 0,
+	kPerformanceCounterScopeKernel		= 1,
+	kPerformanceCounterScopeCount		= 2,
+} PerformanceCounterScope;
+
+typedef struct PerformanceCounters
+{
+	int		groupFd;
+	int		fds[kPerformanceCounterCount];
+	size_t		openCount;
+	uint64_t	startValues[kPerformanceCounterCount];
+	uint64_t	counts[kPerformanceCounterScopeCount][kPerformanceCounterCount];
+	size_t		frameCounts[kPerformanceCounterScopeCount];
+	bool		isMultiplexed;
+} PerformanceCounters;
+
+/**
+ *	@brief	Open the hardware counters of the calling thread (user space only) with perf_event_open(2),
+ *		as one group so that they are read consistently. Events the processor or kernel do not
+ *		provide are skipped.
+ *
+ *	@param	counters	: Counters to open.
+ *	@return	bool		: true if at least one event could be opened, else false (counters are then no-ops).
+ */
+bool	performanceCountersOpen(PerformanceCounters *  counters);
+
+/**
+ *	@brief	Start counting a stage.
+ *
+ *	@param	counters	: Counters, or NULL to do nothing.
+ */
+void	performanceCountersStart(PerformanceCounters *  counters);
+
+/**
+ *	@brief	Charge the events since performanceCountersStart() to a stage, for one frame.
+ *
+ *	@param	counters	: Counters, or NULL to do nothing.
+ *	@param	scope		: Stage to charge.
+ */
+void	performanceCountersStop(PerformanceCounters *  counters, PerformanceCounterScope scope);
+
+/**
+ *	@brief	Print the counts per frame and per converted pixel of every stage, and derived ratios.
+ *
+ *	@param	counters	: Counters.
+ *	@param	pixelsPerFrame	: Pixels converted per frame (one sub-page).
+ */
+void	performanceCountersPrint(const PerformanceCounters *  counters, size_t pixelsPerFrame);
+
+/**
+ *	@brief	Close the counters.
+ *
+ *	@param	counters	: Counters.
+ */
+void	performanceCountersClose(PerformanceCounters *  counters);
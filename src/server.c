@@ -0,0 +1,419 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+/*
+ *	For accept4(2).
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "server.h"
+#include "utilities.h"
+
+typedef enum
+{
+	kServerConstantFrameSize	= kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t),
+	kServerConstantRecordSize	= kFrameWriterConstantRecordHeaderSize + kMLX90640ConstantFrameBufferSize * sizeof(float),
+	kServerConstantMaxRequestSize	= kServerConstantHeaderSize + kServerConstantMaxFramesPerRequest * kServerConstantFrameSize,
+	kServerConstantMaxResponseSize	= kServerConstantHeaderSize + kServerConstantMaxFramesPerRequest * kServerConstantRecordSize,
+} ServerSizeConstant;
+
+typedef struct ServerConnection
+{
+	int		fd;
+	uint8_t *	input;
+	size_t		inputLength;
+	uint8_t *	output;
+	size_t		outputOffset;
+	size_t		outputLength;
+	uint32_t	events;
+	bool		isEndOfInput;
+	bool		isClosing;
+} ServerConnection;
+
+static volatile sig_atomic_t	isServerStopping;
+
+/**
+ *	@brief	Request the event loop to stop.
+ *
+ *	@param	signalNumber	: Signal.
+ */
+static void	stopServer(int signalNumber);
+
+/**
+ *	@brief	Accept all pending connections.
+ *
+ *	@param	epollFd		: epoll instance.
+ *	@param	listenFd	: Listening socket.
+ */
+static void	acceptConnections(int epollFd, int listenFd);
+
+/**
+ *	@brief	Send pending responses, convert complete requests and read, until the connection would
+ *		block, then wait for the events it needs.
+ *
+ *	@param	epollFd		: epoll instance.
+ *	@param	connection	: Connection.
+ *	@param	convertFrame	: Conversion of a raw frame.
+ *	@param	context		: Context for `convertFrame`.
+ *	@return	bool		: false if the connection was closed.
+ */
+static bool	serviceConnection(int epollFd, ServerConnection *  connection, ServerConvertFrame convertFrame, void *  context);
+
+/**
+ *	@brief	Convert the complete requests at the start of the input buffer whose responses fit into the
+ *		output buffer.
+ *
+ *	@param	connection	: Connection.
+ *	@param	convertFrame	: Conversion of a raw frame.
+ *	@param	context		: Context for `convertFrame`.
+ *	@return	bool		: true if any request was handled.
+ */
+static bool	handleRequests(ServerConnection *  connection, ServerConvertFrame convertFrame, void *  context);
+
+/**
+ *	@brief	Close a connection and release its buffers.
+ *
+ *	@param	epollFd		: epoll instance.
+ *	@param	connection	: Connection.
+ */
+static void	closeConnection(int epollFd, ServerConnection *  connection);
+
+CommonConstantReturnType
+serverRun(const char *  socketPath, ServerConvertFrame convertFrame, void *  context)
+{
+	struct sockaddr_un	address = { .sun_family = AF_UNIX };
+	struct epoll_event	events[kServerConstantMaxEvents];
+	struct sigaction	action = { .sa_handler = stopServer };
+	sigset_t		stopSignals;
+	sigset_t		waitMask;
+	int			listenFd;
+	int			epollFd;
+
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	/*
+	 *	The signals are only delivered while waiting for events, so that a
+	 *	stop request between two waits is not lost.
+	 */
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	sigprocmask(SIG_BLOCK, &stopSignals, &waitMask);
+	sigdelset(&waitMask, SIGINT);
+	sigdelset(&waitMask, SIGTERM);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	unlink(socketPath);
+	listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if ((listenFd < 0) || (epollFd < 0) ||
+		(bind(listenFd, (struct sockaddr *)&address, sizeof(address)) != 0) ||
+		(listen(listenFd, kServerConstantListenBacklog) != 0) ||
+		(epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &(struct epoll_event) { .events = EPOLLIN, .data.ptr = NULL }) != 0))
+	{
+		fprintf(stderr, "Error: Could not listen on '%s': %s\n", socketPath, strerror(errno));
+		close(listenFd);
+		close(epollFd);
+		unlink(socketPath);
+		return kCommonConstantReturnTypeError;
+	}
+
+	while (!isServerStopping)
+	{
+		int	eventCount = epoll_pwait(epollFd, events, kServerConstantMaxEvents, -1, &waitMask);
+
+		if (eventCount < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			fprintf(stderr, "Error: Waiting for connections failed: %s\n", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < eventCount; i++)
+		{
+			ServerConnection *	connection = events[i].data.ptr;
+
+			if (connection == NULL)
+			{
+				acceptConnections(epollFd, listenFd);
+			}
+			else if ((events[i].events & EPOLLERR) != 0)
+			{
+				closeConnection(epollFd, connection);
+			}
+			else
+			{
+				serviceConnection(epollFd, connection, convertFrame, context);
+			}
+		}
+	}
+
+	/*
+	 *	Open connections are not tracked outside of epoll, they are closed
+	 *	with the process.
+	 */
+	close(epollFd);
+	close(listenFd);
+	unlink(socketPath);
+	sigprocmask(SIG_UNBLOCK, &stopSignals, NULL);
+
+	return isServerStopping ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+}
+
+static void
+stopServer(int signalNumber)
+{
+	(void)signalNumber;
+	isServerStopping = 1;
+}
+
+static void
+acceptConnections(int epollFd, int listenFd)
+{
+	for (;;)
+	{
+		int			fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		ServerConnection *	connection;
+
+		if (fd < 0)
+		{
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) && (errno != ECONNABORTED))
+			{
+				fprintf(stderr, "Warning: Could not accept a connection: %s\n", strerror(errno));
+			}
+			if (errno != ECONNABORTED)
+			{
+				return;
+			}
+			continue;
+		}
+
+		connection = calloc(1, sizeof(ServerConnection));
+		if (connection != NULL)
+		{
+			connection->fd = fd;
+			connection->events = EPOLLIN;
+			connection->input = malloc(kServerConstantMaxRequestSize);
+			connection->output = malloc(kServerConstantMaxResponseSize);
+		}
+
+		if ((connection == NULL) || (connection->input == NULL) || (connection->output == NULL) ||
+			(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &(struct epoll_event) { .events = EPOLLIN, .data.ptr = connection }) != 0))
+		{
+			fprintf(stderr, "Warning: Could not set up a connection.\n");
+			if (connection != NULL)
+			{
+				free(connection->input);
+				free(connection->output);
+				free(connection);
+			}
+			close(fd);
+		}
+	}
+}
+
+static bool
+serviceConnection(int epollFd, ServerConnection *  connection, ServerConvertFrame convertFrame, void *  context)
+{
+	uint32_t	events;
+
+	for (;;)
+	{
+		/*
+		 *	Send the pending responses first.
+		 */
+		while (connection->outputOffset < connection->outputLength)
+		{
+			ssize_t	written = send(
+						connection->fd,
+						&connection->output[connection->outputOffset],
+						connection->outputLength - connection->outputOffset,
+						MSG_NOSIGNAL);
+
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				{
+					break;
+				}
+				closeConnection(epollFd, connection);
+				return false;
+			}
+			connection->outputOffset += written;
+		}
+
+		if (connection->outputOffset < connection->outputLength)
+		{
+			events = EPOLLOUT;
+			break;
+		}
+		connection->outputOffset = 0;
+		connection->outputLength = 0;
+
+		if (connection->isClosing)
+		{
+			closeConnection(epollFd, connection);
+			return false;
+		}
+
+		if (handleRequests(connection, convertFrame, context))
+		{
+			continue;
+		}
+
+		if (connection->isEndOfInput)
+		{
+			closeConnection(epollFd, connection);
+			return false;
+		}
+
+		/*
+		 *	Only an incomplete request is left, read more of it.
+		 */
+		ssize_t	received = recv(
+					connection->fd,
+					&connection->input[connection->inputLength],
+					kServerConstantMaxRequestSize - connection->inputLength,
+					0);
+
+		if (received < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			{
+				events = EPOLLIN;
+				break;
+			}
+			closeConnection(epollFd, connection);
+			return false;
+		}
+
+		if (received == 0)
+		{
+			connection->isEndOfInput = true;
+		}
+		connection->inputLength += received;
+	}
+
+	if ((events != connection->events) &&
+		(epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &(struct epoll_event) { .events = events, .data.ptr = connection }) == 0))
+	{
+		connection->events = events;
+	}
+
+	return true;
+}
+
+static bool
+handleRequests(ServerConnection *  connection, ServerConvertFrame convertFrame, void *  context)
+{
+	size_t	offset = 0;
+	bool	isHandled = false;
+
+	while ((connection->inputLength - offset >= kServerConstantHeaderSize) && !connection->isClosing)
+	{
+		uint32_t	header[3];
+		uint32_t	response[3] = { kServerConstantResponseMagic, kServerStatusSuccess, 0 };
+		size_t		requestSize;
+		size_t		responseSize;
+
+		memcpy(header, &connection->input[offset], sizeof(header));
+		if ((header[0] != kServerConstantRequestMagic) || (header[2] == 0) || (header[2] > kServerConstantMaxFramesPerRequest))
+		{
+			response[1] = kServerStatusBadRequest;
+			memcpy(&connection->output[connection->outputLength], response, sizeof(response));
+			connection->outputLength += sizeof(response);
+			connection->isClosing = true;
+			isHandled = true;
+			break;
+		}
+
+		requestSize = kServerConstantHeaderSize + (size_t)header[2] * kServerConstantFrameSize;
+		responseSize = kServerConstantHeaderSize + (size_t)header[2] * kServerConstantRecordSize;
+		if ((connection->inputLength - offset < requestSize) || (kServerConstantMaxResponseSize - connection->outputLength < responseSize))
+		{
+			break;
+		}
+
+		/*
+		 *	The frames are copied out of the byte stream, as they are not
+		 *	aligned for uint16_t.
+		 */
+		for (uint32_t f = 0; f < header[2]; f++)
+		{
+			uint16_t	frame[kMLX90640ConstantRawFrameBufferSize];
+			uint8_t *	record = &connection->output[connection->outputLength + kServerConstantHeaderSize + response[2] * kServerConstantRecordSize];
+
+			memcpy(frame, &connection->input[offset + kServerConstantHeaderSize + f * kServerConstantFrameSize], sizeof(frame));
+			if (!convertFrame(context, header[1], frame, record))
+			{
+				response[1] = kServerStatusUnknownSensor;
+				continue;
+			}
+			response[2]++;
+		}
+
+		memcpy(&connection->output[connection->outputLength], response, sizeof(response));
+		connection->outputLength += kServerConstantHeaderSize + response[2] * kServerConstantRecordSize;
+		offset += requestSize;
+		isHandled = true;
+	}
+
+	memmove(connection->input, &connection->input[offset], connection->inputLength - offset);
+	connection->inputLength -= offset;
+
+	return isHandled;
+}
+
+static void
+closeConnection(int epollFd, ServerConnection *  connection)
+{
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+	close(connection->fd);
+	free(connection->input);
+	free(connection->output);
+	free(connection);
+}
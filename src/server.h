@@ -0,0 +1,83 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+/*
+ *	Conversion server on a Unix domain stream socket. Clients send requests and receive one
+ *	response per request, in order. All values have the byte order of the host.
+ *
+ *	Request:	uint32 magic "MLXQ", uint32 sensor id, uint32 number of frames n (1 to
+ *			kServerConstantMaxFramesPerRequest), then n raw frames of 834 uint16 words.
+ *	Response:	uint32 magic "MLXP", uint32 ServerStatus, uint32 number of frames, then one
+ *			record of the f32 output format (frame-writer.h) per frame.
+ *
+ *	After a response with kServerStatusBadRequest the server closes the connection, as it cannot
+ *	find the start of the next request.
+ */
+
+typedef enum
+{
+	kServerStatusSuccess		= 0,
+	kServerStatusUnknownSensor	= 1,	/* No calibration for the sensor id, the frames were skipped */
+	kServerStatusBadRequest		= 2,	/* Wrong magic or number of frames */
+} ServerStatus;
+
+typedef enum
+{
+	kServerConstantRequestMagic		= 0x51584C4D,	/* "MLXQ" read as little-endian uint32 */
+	kServerConstantResponseMagic		= 0x50584C4D,	/* "MLXP" read as little-endian uint32 */
+	kServerConstantHeaderSize		= 12,
+	kServerConstantMaxFramesPerRequest	= 64,
+	kServerConstantMaxEvents		= 64,
+	kServerConstantListenBacklog		= 64,
+} ServerConstant;
+
+/**
+ *	@brief	Convert one raw frame of a request.
+ *
+ *	@param	context		: Context passed to serverRun().
+ *	@param	sensorId	: Sensor id of the request.
+ *	@param	frame		: Raw frame of kMLX90640ConstantRawFrameBufferSize words.
+ *	@param	record		: Destination of the f32 output record of the frame.
+ *	@return	bool		: false if there is no calibration for the sensor.
+ */
+typedef bool	(*ServerConvertFrame)(void *  context, uint32_t sensorId, uint16_t *  frame, uint8_t *  record);
+
+/**
+ *	@brief	Listen on a Unix domain socket and answer conversion requests of any number of clients from
+ *		one epoll(7) loop, until SIGINT or SIGTERM. All complete requests that have arrived on a
+ *		connection are converted before the responses are sent with as few writes as possible. A
+ *		connection is not read while its responses cannot be sent, so every connection holds at most
+ *		one maximum-size request and response in memory.
+ *
+ *	@param	socketPath	: Path of the socket. An existing file at the path is replaced and removed on return.
+ *	@param	convertFrame	: Conversion of a raw frame.
+ *	@param	context		: Context for `convertFrame`.
+ *	@return			: `kCommonConstantReturnTypeSuccess` after a signal, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	serverRun(const char *  socketPath, ServerConvertFrame convertFrame, void *  context);
@@ -0,0 +1,244 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm-ring.h"
+
+/**
+ *	@brief	Map a shared memory object of `size` bytes.
+ *
+ *	@param	ring		: Ring to set up.
+ *	@param	fd		: File descriptor of the shared memory object.
+ *	@param	size		: Size in bytes.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	mapRing(ShmRing *  ring, int fd, size_t size);
+
+CommonConstantReturnType
+shmRingCreate(ShmRing *  ring, const char *  name, size_t slotSize, size_t slotCount)
+{
+	int	fd;
+	size_t	size = kShmRingConstantHeaderSize + slotSize * slotCount;
+
+	if ((slotSize == 0) || (slotSize > UINT32_MAX) || (slotCount == 0) || (slotCount > UINT32_MAX) || ((slotCount & (slotCount - 1)) != 0))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	A ring left over from an earlier run may have another layout or stale
+	 *	indices. Processes that still map it keep their mapping.
+	 */
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((ftruncate(fd, size) != 0) || (mapRing(ring, fd, size) != kCommonConstantReturnTypeSuccess))
+	{
+		close(fd);
+		shm_unlink(name);
+		return kCommonConstantReturnTypeError;
+	}
+	close(fd);
+
+	ring->header->slotSize = slotSize;
+	ring->header->slotCount = slotCount;
+	ring->header->version = kShmRingConstantVersion;
+	atomic_init(&ring->header->head, 0);
+	atomic_init(&ring->header->tail, 0);
+	atomic_init(&ring->header->isEnded, 0);
+
+	/*
+	 *	The magic is written last, so that a consumer opening the ring
+	 *	concurrently does not accept a half-initialized header.
+	 */
+	atomic_store_explicit(&ring->header->magic, kShmRingConstantMagic, memory_order_release);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+shmRingOpen(ShmRing *  ring, const char *  name, size_t slotSize)
+{
+	int		fd;
+	struct stat	status;
+	size_t		size;
+	uint32_t	slotCount;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((fstat(fd, &status) != 0) || (status.st_size < kShmRingConstantHeaderSize) ||
+		(mapRing(ring, fd, status.st_size) != kCommonConstantReturnTypeSuccess))
+	{
+		close(fd);
+		return kCommonConstantReturnTypeError;
+	}
+	close(fd);
+
+	/*
+	 *	The layout is only read after the magic, which the producer writes last.
+	 */
+	if (atomic_load_explicit(&ring->header->magic, memory_order_acquire) != kShmRingConstantMagic)
+	{
+		shmRingClose(ring);
+		return kCommonConstantReturnTypeError;
+	}
+
+	slotCount = ring->header->slotCount;
+	size = kShmRingConstantHeaderSize + (size_t)ring->header->slotSize * slotCount;
+	if ((ring->header->version != kShmRingConstantVersion) || (ring->header->slotSize != slotSize) ||
+		(slotCount == 0) || ((slotCount & (slotCount - 1)) != 0) || (size > ring->mappingSize))
+	{
+		shmRingClose(ring);
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+void
+shmRingClose(ShmRing *  ring)
+{
+	if (ring->header != NULL)
+	{
+		munmap(ring->header, ring->mappingSize);
+	}
+
+	*ring = (ShmRing) { 0 };
+}
+
+void *
+shmRingAcquireWrite(ShmRing *  ring)
+{
+	uint64_t	head = atomic_load_explicit(&ring->header->head, memory_order_relaxed);
+	uint64_t	tail = atomic_load_explicit(&ring->header->tail, memory_order_acquire);
+
+	if (head - tail >= ring->header->slotCount)
+	{
+		return NULL;
+	}
+
+	return &ring->slots[(head & (ring->header->slotCount - 1)) * ring->header->slotSize];
+}
+
+void
+shmRingCommitWrite(ShmRing *  ring)
+{
+	uint64_t	head = atomic_load_explicit(&ring->header->head, memory_order_relaxed);
+
+	atomic_store_explicit(&ring->header->head, head + 1, memory_order_release);
+}
+
+void
+shmRingEnd(ShmRing *  ring)
+{
+	atomic_store_explicit(&ring->header->isEnded, 1, memory_order_release);
+}
+
+void *
+shmRingAcquireRead(ShmRing *  ring)
+{
+	uint64_t	tail = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+	uint64_t	head = atomic_load_explicit(&ring->header->head, memory_order_acquire);
+
+	if (tail == head)
+	{
+		return NULL;
+	}
+
+	return &ring->slots[(tail & (ring->header->slotCount - 1)) * ring->header->slotSize];
+}
+
+void
+shmRingReleaseRead(ShmRing *  ring)
+{
+	uint64_t	tail = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+
+	atomic_store_explicit(&ring->header->tail, tail + 1, memory_order_release);
+}
+
+size_t
+shmRingGetCount(ShmRing *  ring)
+{
+	uint64_t	tail = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+
+	return atomic_load_explicit(&ring->header->head, memory_order_acquire) - tail;
+}
+
+bool
+shmRingIsFinished(ShmRing *  ring)
+{
+	/*
+	 *	The end flag is read before head, so a slot committed just before
+	 *	the end is not missed.
+	 */
+	bool	isEnded = atomic_load_explicit(&ring->header->isEnded, memory_order_acquire) != 0;
+
+	return isEnded &&
+		(atomic_load_explicit(&ring->header->tail, memory_order_relaxed) == atomic_load_explicit(&ring->header->head, memory_order_acquire));
+}
+
+void
+shmRingBackOff(size_t *  attempt)
+{
+	if (*attempt < kShmRingConstantSpinCount)
+	{
+		(*attempt)++;
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+		return;
+	}
+
+	nanosleep(&(struct timespec) { .tv_sec = 0, .tv_nsec = kShmRingConstantIdleSleepNanoseconds }, NULL);
+}
+
+static CommonConstantReturnType
+mapRing(ShmRing *  ring, int fd, size_t size)
+{
+	void *	mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (mapping == MAP_FAILED)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	ring->header = mapping;
+	ring->slots = (uint8_t *)mapping + kShmRingConstantHeaderSize;
+	ring->mappingSize = size;
+
+	return kCommonConstantReturnTypeSuccess;
+}
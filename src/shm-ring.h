@@ -0,0 +1,174 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "common.h"
+
+/*
+ *	Single-producer single-consumer ring buffer of fixed-size slots in POSIX shared memory
+ *	(shm_open(3)), so that two processes exchange frames without copying them through pipes
+ *	and without system calls per frame.
+ *
+ *	The shared memory object starts with a header of kShmRingConstantHeaderSize bytes:
+ *
+ *		offset 0	uint32	magic "MLXR"
+ *		offset 4	uint16	version
+ *		offset 8	uint32	slot size in bytes
+ *		offset 12	uint32	number of slots, a power of two
+ *		offset 64	uint64	head: number of slots written by the producer
+ *		offset 128	uint64	tail: number of slots released by the consumer
+ *		offset 192	uint32	non-zero once the producer has written its last slot
+ *
+ *	followed by the slots. The magic is stored last (release) when the ring is created and loaded
+ *	first (acquire) when it is opened. head, tail and the end flag are lock-free atomics, each on its own
+ *	cache line. Slot `n % count` starts at offset kShmRingConstantHeaderSize + (n % count) * size.
+ *	The producer fills slot `head` while head - tail < count and then publishes it by incrementing
+ *	head (release). The consumer reads slot `tail` in place while tail < head (acquire) and then
+ *	gives it back by incrementing tail (release). All values have the byte order of the host.
+ */
+
+typedef enum
+{
+	kShmRingConstantMagic			= 0x52584C4D,	/* "MLXR" read as little-endian uint32 */
+	kShmRingConstantVersion			= 1,
+	kShmRingConstantHeaderSize		= 256,
+	kShmRingConstantDefaultSlotCount	= 64,
+	kShmRingConstantSpinCount		= 1024,
+	kShmRingConstantIdleSleepNanoseconds	= 50000,
+} ShmRingConstant;
+
+typedef struct ShmRingHeader
+{
+	_Atomic(uint32_t)			magic;		/* Written last by the producer (release) */
+	uint16_t				version;
+	uint16_t				reserved;
+	uint32_t				slotSize;
+	uint32_t				slotCount;
+	_Alignas(64) _Atomic(uint64_t)		head;
+	_Alignas(64) _Atomic(uint64_t)		tail;
+	_Alignas(64) _Atomic(uint32_t)		isEnded;
+} ShmRingHeader;
+
+_Static_assert(sizeof(_Atomic(uint32_t)) == sizeof(uint32_t), "The magic must be a plain uint32 in shared memory");
+_Static_assert(sizeof(ShmRingHeader) <= kShmRingConstantHeaderSize, "The ring header must fit in kShmRingConstantHeaderSize bytes");
+
+typedef struct ShmRing
+{
+	ShmRingHeader *	header;
+	uint8_t *	slots;
+	size_t		mappingSize;
+} ShmRing;
+
+/**
+ *	@brief	Create a ring, replacing any shared memory object of the same name.
+ *
+ *	@param	ring		: Ring to set up.
+ *	@param	name		: Name of the shared memory object, e.g. "/mlx90640-frames".
+ *	@param	slotSize	: Size of a slot in bytes.
+ *	@param	slotCount	: Number of slots, a power of two.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	shmRingCreate(ShmRing *  ring, const char *  name, size_t slotSize, size_t slotCount);
+
+/**
+ *	@brief	Map an existing ring.
+ *
+ *	@param	ring		: Ring to set up.
+ *	@param	name		: Name of the shared memory object.
+ *	@param	slotSize	: Expected size of a slot in bytes.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if the ring exists and has the expected layout, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	shmRingOpen(ShmRing *  ring, const char *  name, size_t slotSize);
+
+/**
+ *	@brief	Unmap a ring. The shared memory object stays until it is removed with shm_unlink(3).
+ *
+ *	@param	ring		: Ring.
+ */
+void	shmRingClose(ShmRing *  ring);
+
+/**
+ *	@brief	Get the next slot to write, without waiting.
+ *
+ *	@param	ring		: Ring.
+ *	@return			: Slot, or NULL if the ring is full.
+ */
+void *	shmRingAcquireWrite(ShmRing *  ring);
+
+/**
+ *	@brief	Publish the slot returned by the last shmRingAcquireWrite() to the consumer.
+ *
+ *	@param	ring		: Ring.
+ */
+void	shmRingCommitWrite(ShmRing *  ring);
+
+/**
+ *	@brief	Mark that the producer will not write any more slots.
+ *
+ *	@param	ring		: Ring.
+ */
+void	shmRingEnd(ShmRing *  ring);
+
+/**
+ *	@brief	Get the oldest unread slot, without waiting.
+ *
+ *	@param	ring		: Ring.
+ *	@return			: Slot, valid until shmRingReleaseRead(), or NULL if the ring is empty.
+ */
+void *	shmRingAcquireRead(ShmRing *  ring);
+
+/**
+ *	@brief	Give the slot returned by the last shmRingAcquireRead() back to the producer.
+ *
+ *	@param	ring		: Ring.
+ */
+void	shmRingReleaseRead(ShmRing *  ring);
+
+/**
+ *	@brief	Get the number of slots written and not yet released.
+ *
+ *	@param	ring		: Ring.
+ *	@return	size_t		: Number of slots.
+ */
+size_t	shmRingGetCount(ShmRing *  ring);
+
+/**
+ *	@brief	Whether the producer has ended the ring and the consumer has read all slots.
+ *
+ *	@param	ring		: Ring.
+ *	@return	bool		: true when no more slots will become readable.
+ */
+bool	shmRingIsFinished(ShmRing *  ring);
+
+/**
+ *	@brief	Wait before retrying an acquire that failed: spin for the first
+ *		kShmRingConstantSpinCount attempts, then sleep kShmRingConstantIdleSleepNanoseconds,
+ *		so that only an idle ring costs system calls.
+ *
+ *	@param	attempt		: Number of failed attempts so far, incremented. Reset it to 0 after a successful acquire.
+ */
+void	shmRingBackOff(size_t *  attempt);
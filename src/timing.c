@@ -0,0 +1,165 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timing.h"
+#include "utilities.h"
+
+static const char *	kTimingStageNames[kTimingStageCount] = {
+	[kTimingStageParse]	= "parse",
+	[kTimingStageExtract]	= "extract",
+	[kTimingStageAmbient]	= "ambient",
+	[kTimingStageKernel]	= "kernel",
+	[kTimingStageOutput]	= "output",
+};
+
+void
+timingInit(TimingReport *  report)
+{
+	memset(report, 0, sizeof(*report));
+	latencyHistogramInit(&report->frames);
+}
+
+uint64_t
+timingRecordStage(TimingReport *  report, TimingStage stage, uint64_t begin)
+{
+	uint64_t	now;
+
+	if (report == NULL)
+	{
+		return 0;
+	}
+
+	now = getMonotonicTimeNanoseconds();
+	report->stageNanoseconds[stage] += now - begin;
+
+	return now;
+}
+
+void
+timingRecordFrame(TimingReport *  report, uint64_t begin, uint64_t end)
+{
+	if (report == NULL)
+	{
+		return;
+	}
+
+	latencyHistogramRecord(&report->frames, end - begin);
+}
+
+void
+timingSummarize(TimingReport *  report)
+{
+	uint64_t	conversionNanoseconds = 0;
+	uint64_t	frameCount = report->frames.totalCount;
+
+	for (size_t s = 0; s < kTimingStageCount; s++)
+	{
+		report->stageSeconds[s] = report->stageNanoseconds[s] * 1e-9;
+	}
+
+	conversionNanoseconds = report->stageNanoseconds[kTimingStageParse] + report->stageNanoseconds[kTimingStageExtract] +
+				report->stageNanoseconds[kTimingStageAmbient] + report->stageNanoseconds[kTimingStageKernel];
+	report->framesPerSecond = (conversionNanoseconds > 0) ? frameCount / (conversionNanoseconds * 1e-9) : 0;
+
+	if (frameCount == 0)
+	{
+		report->frameMinimum = report->frameMean = report->frameP99 = 0;
+		return;
+	}
+
+	report->frameMinimum = report->frames.minimum * 1e-9;
+	report->frameMean = (report->frames.sum * 1e-9) / frameCount;
+	report->frameP99 = latencyHistogramPercentile(&report->frames, 99) * 1e-9;
+}
+
+void
+timingPrint(const TimingReport *  report)
+{
+	double	total = 0;
+
+	printf("Timing (CLOCK_MONOTONIC):\n");
+	for (size_t s = 0; s < kTimingStageCount; s++)
+	{
+		printf("\t%-8s %12.6f seconds\n", kTimingStageNames[s], report->stageSeconds[s]);
+		total += report->stageSeconds[s];
+	}
+	printf("\t%-8s %12.6f seconds\n", "total", total);
+	printf(
+		"Frames: %" PRIu64 ", latency min/mean/p99: %.3f/%.3f/%.3f microseconds, %.1f frames/s\n",
+		report->frames.totalCount,
+		report->frameMinimum * 1e6,
+		report->frameMean * 1e6,
+		report->frameP99 * 1e6,
+		report->framesPerSecond);
+}
+
+size_t
+timingGetJSONVariables(TimingReport *  report, JSONvariable *  variables)
+{
+	variables[0] = (JSONvariable) {
+		.variableSymbol = "stageSeconds",
+		.variableDescription = "Time per stage in seconds (parse, extract, ambient, kernel, output)",
+		.values = (JSONvariablePointer) { .asDouble = report->stageSeconds },
+		.type = kJSONvariableTypeDouble,
+		.size = kTimingStageCount,
+	};
+	variables[1] = (JSONvariable) {
+		.variableSymbol = "frameSecondsMinimum",
+		.variableDescription = "Minimum frame latency in seconds",
+		.values = (JSONvariablePointer) { .asDouble = &report->frameMinimum },
+		.type = kJSONvariableTypeDouble,
+		.size = 1,
+	};
+	variables[2] = (JSONvariable) {
+		.variableSymbol = "frameSecondsMean",
+		.variableDescription = "Mean frame latency in seconds",
+		.values = (JSONvariablePointer) { .asDouble = &report->frameMean },
+		.type = kJSONvariableTypeDouble,
+		.size = 1,
+	};
+	variables[3] = (JSONvariable) {
+		.variableSymbol = "frameSecondsP99",
+		.variableDescription = "99th percentile frame latency in seconds",
+		.values = (JSONvariablePointer) { .asDouble = &report->frameP99 },
+		.type = kJSONvariableTypeDouble,
+		.size = 1,
+	};
+	variables[4] = (JSONvariable) {
+		.variableSymbol = "framesPerSecond",
+		.variableDescription = "Frames converted per second",
+		.values = (JSONvariablePointer) { .asDouble = &report->framesPerSecond },
+		.type = kJSONvariableTypeDouble,
+		.size = 1,
+	};
+
+	return kTimingConstantJSONVariableCount;
+}
+
+const char *
+timingGetStageName(TimingStage stage)
+{
+	return kTimingStageNames[stage];
+}
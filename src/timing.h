@@ -0,0 +1,121 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "latency-histogram.h"
+
+/*
+ *	Stages of the conversion example that are timed separately.
+ */
+typedef enum
+{
+	kTimingStageParse	= 0,	/* Reading (or acquiring) a raw frame */
+	kTimingStageExtract	= 1,	/* MLX90640_ExtractParameters and kernel preparation */
+	kTimingStageAmbient	= 2,	/* MLX90640_GetTa for the reflected temperature */
+	kTimingStageKernel	= 3,	/* To calculation */
+	kTimingStageOutput	= 4,	/* Printing the results */
+	kTimingStageCount	= 5,
+} TimingStage;
+
+typedef enum
+{
+	kTimingConstantJSONVariableCount	= 5,
+} TimingConstant;
+
+typedef struct TimingReport
+{
+	uint64_t		stageNanoseconds[kTimingStageCount];
+	LatencyHistogram	frames;		/* Per-frame latencies, in fixed memory however long the run */
+
+	/*
+	 *	Filled in by timingSummarize(), in seconds.
+	 */
+	double			stageSeconds[kTimingStageCount];
+	double			frameMinimum;
+	double			frameMean;
+	double			frameP99;
+	double			framesPerSecond;
+} TimingReport;
+
+/**
+ *	@brief	Empty a report.
+ *
+ *	@param	report		: Timing report.
+ */
+void	timingInit(TimingReport *  report);
+
+/**
+ *	@brief	Add the time since `begin` to a stage.
+ *
+ *	@param	report		: Timing report, or NULL to do nothing.
+ *	@param	stage		: Stage to charge.
+ *	@param	begin		: Start of the stage, from getMonotonicTimeNanoseconds().
+ *	@return	uint64_t	: The current time, to be used as the start of the next stage.
+ */
+uint64_t	timingRecordStage(TimingReport *  report, TimingStage stage, uint64_t begin);
+
+/**
+ *	@brief	Record the latency of one frame, from the start of its parse stage to the end of its kernel stage.
+ *
+ *	@param	report		: Timing report, or NULL to do nothing.
+ *	@param	begin		: Start of the frame, from getMonotonicTimeNanoseconds().
+ *	@param	end		: End of the frame, from getMonotonicTimeNanoseconds().
+ */
+void	timingRecordFrame(TimingReport *  report, uint64_t begin, uint64_t end);
+
+/**
+ *	@brief	Compute the per-stage totals, the per-frame minimum, mean and 99th percentile latency and the
+ *		frame rate over the parse, extract, ambient and kernel stages. The percentile is resolved to
+ *		the 0.8 % buckets of a LatencyHistogram.
+ *
+ *	@param	report		: Timing report.
+ */
+void	timingSummarize(TimingReport *  report);
+
+/**
+ *	@brief	Print a summarized report as text.
+ *
+ *	@param	report		: Timing report.
+ */
+void	timingPrint(const TimingReport *  report);
+
+/**
+ *	@brief	Describe a summarized report as JSON variables, for printJSONVariables().
+ *
+ *	@param	report		: Timing report.
+ *	@param	variables	: Destination of kTimingConstantJSONVariableCount variables.
+ *	@return	size_t		: Number of variables written.
+ */
+size_t	timingGetJSONVariables(TimingReport *  report, JSONvariable *  variables);
+
+/**
+ *	@brief	Name of a stage, as used in the reports.
+ *
+ *	@param	stage		: Stage.
+ *	@return	const char *	: Name of the stage.
+ */
+const char *	timingGetStageName(TimingStage stage);
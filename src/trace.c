@@ -0,0 +1,221 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "trace.h"
+#include "utilities.h"
+
+typedef struct TraceEvent
+{
+	const char *	name;
+	uint64_t	begin;
+	uint64_t	duration;
+	int64_t		argument;
+} TraceEvent;
+
+/*
+ *	Only the owning thread writes to a buffer. Buffers are pushed onto a
+ *	lock-free list when a thread records its first event, or by traceInit()
+ *	for the calling thread, and are only read by traceFlush().
+ */
+typedef struct TraceBuffer
+{
+	struct TraceBuffer *	next;
+	uint32_t		threadId;
+	size_t			count;
+	uint64_t		dropped;
+	TraceEvent		events[kTraceConstantEventsPerThread];
+} TraceBuffer;
+
+static bool				traceEnabled;
+static char				tracePath[kCommonConstantMaxCharsPerFilepath];
+static uint64_t				traceOrigin;
+static _Atomic(TraceBuffer *)		traceBuffers;
+static atomic_uint			traceThreadCount;
+static _Thread_local TraceBuffer *	threadBuffer;
+
+/**
+ *	@brief	Buffer of the calling thread, allocated and registered on first use.
+ *
+ *	@return	TraceBuffer *	: Buffer, or NULL if it could not be allocated.
+ */
+static TraceBuffer *	getThreadBuffer(void);
+
+CommonConstantReturnType
+traceInit(const char *  path)
+{
+	FILE *	file = fopen(path, "w");
+
+	/*
+	 *	Fail early rather than losing the trace at exit.
+	 */
+	if (file == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+	fclose(file);
+
+	/*
+	 *	The calling thread registers first, so that it gets thread id 1 ("main")
+	 *	even if another thread records an event before it.
+	 */
+	if (getThreadBuffer() == NULL)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	snprintf(tracePath, sizeof(tracePath), "%s", path);
+	traceOrigin = getMonotonicTimeNanoseconds();
+	traceEnabled = true;
+	atexit(traceFlush);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+uint64_t
+traceBegin(void)
+{
+	return traceEnabled ? getMonotonicTimeNanoseconds() : 0;
+}
+
+void
+traceEnd(const char *  name, uint64_t begin, int64_t argument)
+{
+	TraceBuffer *	buffer;
+	uint64_t	end;
+
+	if (!traceEnabled)
+	{
+		return;
+	}
+
+	end = getMonotonicTimeNanoseconds();
+	buffer = (threadBuffer != NULL) ? threadBuffer : getThreadBuffer();
+	if (buffer == NULL)
+	{
+		return;
+	}
+
+	if (buffer->count == kTraceConstantEventsPerThread)
+	{
+		buffer->dropped++;
+		return;
+	}
+
+	buffer->events[buffer->count++] = (TraceEvent) {
+		.name		= name,
+		.begin		= begin,
+		.duration	= end - begin,
+		.argument	= argument,
+	};
+}
+
+void
+traceFlush(void)
+{
+	FILE *		file;
+	bool		isFirst = true;
+	uint64_t	dropped = 0;
+
+	if (!traceEnabled)
+	{
+		return;
+	}
+	traceEnabled = false;
+
+	file = fopen(tracePath, "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error: Could not write trace file '%s'.\n", tracePath);
+		return;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (TraceBuffer *  buffer = atomic_load(&traceBuffers); buffer != NULL; buffer = buffer->next)
+	{
+		fprintf(
+			file,
+			"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s %" PRIu32 "\"}}",
+			isFirst ? "" : ",\n",
+			buffer->threadId,
+			(buffer->threadId == 1) ? "main" : "worker",
+			buffer->threadId);
+		isFirst = false;
+
+		for (size_t i = 0; i < buffer->count; i++)
+		{
+			const TraceEvent *	event = &buffer->events[i];
+
+			/*
+			 *	Timestamps are in microseconds relative to traceInit().
+			 */
+			fprintf(
+				file,
+				",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f,\"dur\":%.3f",
+				event->name,
+				buffer->threadId,
+				(event->begin - traceOrigin) * 1e-3,
+				event->duration * 1e-3);
+			if (event->argument != kTraceConstantNoArgument)
+			{
+				fprintf(file, ",\"args\":{\"frame\":%" PRId64 "}", event->argument);
+			}
+			fprintf(file, "}");
+		}
+		dropped += buffer->dropped;
+	}
+	fprintf(file, "\n]}\n");
+
+	if (fclose(file) != 0)
+	{
+		fprintf(stderr, "Error: Could not write trace file '%s'.\n", tracePath);
+	}
+
+	if (dropped > 0)
+	{
+		fprintf(stderr, "Warning: %" PRIu64 " trace events were dropped, the per-thread buffers were full.\n", dropped);
+	}
+}
+
+static TraceBuffer *
+getThreadBuffer(void)
+{
+	TraceBuffer *	buffer = calloc(1, sizeof(TraceBuffer));
+
+	if (buffer == NULL)
+	{
+		return NULL;
+	}
+
+	buffer->threadId = atomic_fetch_add(&traceThreadCount, 1) + 1;
+	buffer->next = atomic_load(&traceBuffers);
+	while (!atomic_compare_exchange_weak(&traceBuffers, &buffer->next, buffer))
+	{
+	}
+	threadBuffer = buffer;
+
+	return buffer;
+}
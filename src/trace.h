@@ -0,0 +1,67 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+typedef enum
+{
+	kTraceConstantEventsPerThread	= 1 << 16,
+	kTraceConstantNoArgument	= -1,
+} TraceConstant;
+
+/**
+ *	@brief	Enable tracing. Events are recorded into a fixed-size buffer per thread, without locks,
+ *		and written to `path` as Chrome trace JSON (loadable in chrome://tracing or Perfetto) by
+ *		traceFlush(), which is also registered to run at exit. Events beyond the capacity of a
+ *		thread's buffer are dropped and counted. The calling thread is labelled "main".
+ *
+ *	@param	path		: Path of the trace file.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	traceInit(const char *  path);
+
+/**
+ *	@brief	Start of a traced scope.
+ *
+ *	@return	uint64_t	: Timestamp to pass to traceEnd(), 0 when tracing is disabled.
+ */
+uint64_t	traceBegin(void);
+
+/**
+ *	@brief	Record a complete event from `begin` to now on the calling thread.
+ *
+ *	@param	name		: Event name, a string literal or other string that outlives the trace.
+ *	@param	begin		: Timestamp from traceBegin().
+ *	@param	argument	: Integer shown as the `frame` argument of the event, or kTraceConstantNoArgument.
+ */
+void	traceEnd(const char *  name, uint64_t begin, int64_t argument);
+
+/**
+ *	@brief	Write all recorded events to the trace file and disable tracing. Must not race with
+ *		threads still recording events.
+ */
+void	traceFlush(void);
@@ -28,14 +28,19 @@
 #include <string.h>
 #include <getopt.h>
 #include <errno.h>
+#include <time.h>
 #include <uxhw.h>
 #include <assert.h>
+#include <sys/stat.h>
 #include "utilities.h"
 #include "common.h"
+#include "batch-reader.h"
 
 static const char *		kDefaultEEDataPath = "EEPROM-calibration-data.csv";
 static const char *		kDefaultRawDataPath = "raw-frame-data.csv";
 static const unsigned int	kDefaultPixel = (kMLX90640ConstantFrameBufferSize / 2) + (kMLX90640ConstantFrameWidth / 2);
+static const float		kDefaultSparseThreshold = 0.1f;
+static const unsigned int	kDefaultKeyframeInterval = 64;
 
 void
 printUsage(void)
@@ -47,10 +52,34 @@ printUsage(void)
 		stderr,
 		"	[-c, --ee-data <path to sensor ee constants file: str (Default: '%s')>]\n"
 		"	[-e, --emissivity <emissivity : float (Default: 'UniformDist(0.93, 0.97)')>]\n"
+		"	[-m, --emissivity-map <path to per-pixel emissivity map (CSV, or '.bin' float32) : str>]\n"
+		"	[-s, --emissivity-sweep <start:stop:step : float:float:float>] (Convert for every emissivity in the range.)\n"
 		"	[-q, --quantization-error] (Disable ADC quantization error.)\n"
+		"	[-r, --root-precision <exact|float|fast : str (Default: 'exact')>] (Precision of the fourth roots in the To calculation, 'fast' requires -q and -e.)\n"
+		"	[-P, --precision <float|double|fixed : str (Default: 'float')>] (Arithmetic type of the To calculation.)\n"
+		"	[-d, --input-format <csv|bin : str (Default: 'csv')>] (Encoding of the raw frames of -i, '-' reads them from stdin.)\n"
+		"	[-n, --files-in-flight <files : int, range = [1,%d] (Default: '%d')>] (Files read ahead when -i is a directory of recordings.)\n"
+		"	[-A, --prefetch-depth <frames : int (Default: '0')>] (Read and parse up to this many frames of -i ahead on a reader thread.)\n"
+		"	[-f, --format <text|fixed|f32|i16|jsonl|sparse : str (Default: 'text')>] (Encoding of the temperatures. f32, i16, jsonl and sparse write every frame.)\n"
+		"	[-D, --sparse-threshold <change in Celsius : float (Default: '%.1f')>] (Only with -f sparse.)\n"
+		"	[-K, --keyframe-interval <frames between full frames : int (Default: '%u')>] (Only with -f sparse.)\n"
+		"	[-R, --replay] (Acquire frames through the MLX90640 I2C path, replaying the EEPROM and raw frame data.)\n"
+		"	[-B, --i2c-frequency <emulated I2C bus frequency in kHz : int (Default: unlimited)>] (Only with -R.)\n"
+		"	[-F, --refresh-rate <emulated refresh rate in Hz, 0.5 to 64 : float (Default: unlimited)>] (Only with -R.)\n"
+		"	[-C, --performance-counters] (Count hardware events of the parse and kernel stages.)\n"
+		"	[-L, --latency-histogram <report period in seconds, 0 to report on exit only : float>] (Record per-frame latencies.)\n"
+		"	[-t, --trace <path to Chrome trace JSON file : str>] (Record pipeline events and write them at exit.)\n"
+		"	[-X, --metrics <path to Prometheus metrics file : str>] (Rewrite conversion metrics to the file every second.)\n"
+		"	[-I, --shm-input <name of shared memory ring of raw frames : str>] (Convert the frames of the ring instead of -i.)\n"
+		"	[-O, --shm-output <name of shared memory ring of temperature frames : str>] (Only with -I.)\n"
+		"	[-U, --server <path of Unix domain socket : str>] (Serve conversion requests for every sensor of the EEPROM file.)\n"
 		"	[-p, --pixel <Selected pixel : int, range = [0,%d] (Default: '%u')>]\n"
 		"	[-a, --print-all-temperatures] (Print all temperature measurements.)\n",
 		kDefaultEEDataPath,
+		kBatchReaderConstantMaxDepth,
+		kBatchReaderConstantDefaultDepth,
+		kDefaultSparseThreshold,
+		kDefaultKeyframeInterval,
 		kMLX90640ConstantFrameBufferSize - 1,
 		kDefaultPixel);
 	fprintf(stderr, "\n");
@@ -76,9 +105,32 @@ setDefaultCommandLineArguments(CommandLineArguments *  arguments)
 		.common			= (CommonCommandLineArguments) { 0 },
 		.eeDataPath		= "",
 		.rawDataPath		= "",
+		.emissivityMapPath	= "",
+		.tracePath		= "",
+		.metricsPath		= "",
+		.shmInputName		= "",
+		.shmOutputName		= "",
+		.serverSocketPath	= "",
 		.modelQuantizationError	= true,
 		.printAllTemperatures	= false,
 		.emissivity		= UxHwFloatUniformDist(kMLX90640ConstantEmissivityDistributionLowerBound, kMLX90640ConstantEmissivityDistributionUpperBound),
+		.emissivitySweepStart	= 0,
+		.emissivitySweepStep	= 0,
+		.emissivitySweepCount	= 0,
+		.rootPrecision		= kMLX90640RootPrecisionExact,
+		.precision		= kMLX90640PrecisionFloat,
+		.outputFormat		= kOutputFormatText,
+		.inputFormat		= kFrameReaderFormatCSV,
+		.prefetchDepth		= 0,
+		.isRawDataDirectory	= false,
+		.filesInFlight		= kBatchReaderConstantDefaultDepth,
+		.sparseThreshold	= kDefaultSparseThreshold,
+		.keyframeInterval	= kDefaultKeyframeInterval,
+		.isReplayEnabled	= false,
+		.i2cFrequency		= 0,
+		.refreshRateCode	= -1,
+		.isPerformanceCountersEnabled	= false,
+		.latencyReportPeriod	= -1,
 		.pixel			= kDefaultPixel,
 	};
 #pragma GCC diagnostic pop
@@ -101,7 +153,26 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 	const char *	eeDataArg = NULL;
 	const char *	emissivityArg = NULL;
 	const char *	pixelArg = NULL;
+	const char *	emissivityMapArg = NULL;
+	const char *	emissivitySweepArg = NULL;
+	const char *	rootPrecisionArg = NULL;
+	const char *	precisionArg = NULL;
+	const char *	formatArg = NULL;
+	const char *	inputFormatArg = NULL;
+	const char *	prefetchDepthArg = NULL;
+	const char *	filesInFlightArg = NULL;
+	const char *	sparseThresholdArg = NULL;
+	const char *	keyframeIntervalArg = NULL;
+	const char *	i2cFrequencyArg = NULL;
+	const char *	refreshRateArg = NULL;
+	const char *	latencyReportPeriodArg = NULL;
+	const char *	traceArg = NULL;
+	const char *	metricsArg = NULL;
+	const char *	shmInputArg = NULL;
+	const char *	shmOutputArg = NULL;
+	const char *	serverArg = NULL;
 	bool		disableQuantisationError = false;
+	struct stat	status;
 
 	assert(arguments != NULL);
 	setDefaultCommandLineArguments(arguments);
@@ -109,6 +180,26 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 	DemoOption	options[] = {
 		{ .opt = "c", .optAlternative = "ee-data",			.hasArg = true,  .foundArg = &eeDataArg,     .foundOpt = NULL },
 		{ .opt = "e", .optAlternative = "emissivity",			.hasArg = true,  .foundArg = &emissivityArg, .foundOpt = NULL },
+		{ .opt = "m", .optAlternative = "emissivity-map",		.hasArg = true,  .foundArg = &emissivityMapArg, .foundOpt = NULL },
+		{ .opt = "s", .optAlternative = "emissivity-sweep",		.hasArg = true,  .foundArg = &emissivitySweepArg, .foundOpt = NULL },
+		{ .opt = "r", .optAlternative = "root-precision",		.hasArg = true,  .foundArg = &rootPrecisionArg, .foundOpt = NULL },
+		{ .opt = "P", .optAlternative = "precision",			.hasArg = true,  .foundArg = &precisionArg,  .foundOpt = NULL },
+		{ .opt = "d", .optAlternative = "input-format",		.hasArg = true,  .foundArg = &inputFormatArg, .foundOpt = NULL },
+		{ .opt = "n", .optAlternative = "files-in-flight",		.hasArg = true,  .foundArg = &filesInFlightArg, .foundOpt = NULL },
+		{ .opt = "A", .optAlternative = "prefetch-depth",		.hasArg = true,  .foundArg = &prefetchDepthArg, .foundOpt = NULL },
+		{ .opt = "f", .optAlternative = "format",			.hasArg = true,  .foundArg = &formatArg,     .foundOpt = NULL },
+		{ .opt = "D", .optAlternative = "sparse-threshold",		.hasArg = true,  .foundArg = &sparseThresholdArg, .foundOpt = NULL },
+		{ .opt = "K", .optAlternative = "keyframe-interval",		.hasArg = true,  .foundArg = &keyframeIntervalArg, .foundOpt = NULL },
+		{ .opt = "R", .optAlternative = "replay",			.hasArg = false, .foundArg = NULL,           .foundOpt = &arguments->isReplayEnabled },
+		{ .opt = "B", .optAlternative = "i2c-frequency",		.hasArg = true,  .foundArg = &i2cFrequencyArg, .foundOpt = NULL },
+		{ .opt = "F", .optAlternative = "refresh-rate",			.hasArg = true,  .foundArg = &refreshRateArg, .foundOpt = NULL },
+		{ .opt = "C", .optAlternative = "performance-counters",	.hasArg = false, .foundArg = NULL,           .foundOpt = &arguments->isPerformanceCountersEnabled },
+		{ .opt = "L", .optAlternative = "latency-histogram",		.hasArg = true,  .foundArg = &latencyReportPeriodArg, .foundOpt = NULL },
+		{ .opt = "t", .optAlternative = "trace",			.hasArg = true,  .foundArg = &traceArg,      .foundOpt = NULL },
+		{ .opt = "X", .optAlternative = "metrics",			.hasArg = true,  .foundArg = &metricsArg,    .foundOpt = NULL },
+		{ .opt = "I", .optAlternative = "shm-input",			.hasArg = true,  .foundArg = &shmInputArg,   .foundOpt = NULL },
+		{ .opt = "O", .optAlternative = "shm-output",			.hasArg = true,  .foundArg = &shmOutputArg,  .foundOpt = NULL },
+		{ .opt = "U", .optAlternative = "server",			.hasArg = true,  .foundArg = &serverArg,     .foundOpt = NULL },
 		{ .opt = "q", .optAlternative = "quantization-error",		.hasArg = false, .foundArg = NULL,           .foundOpt = &disableQuantisationError },
 		{ .opt = "p", .optAlternative = "pixel",			.hasArg = true,  .foundArg = &pixelArg,      .foundOpt = NULL },
 		{ .opt = "a", .optAlternative = "print-all-temperatures",	.hasArg = false, .foundArg = NULL,           .foundOpt = &arguments->printAllTemperatures },
@@ -130,12 +221,6 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		exit(EXIT_SUCCESS);
 	}
 
-	if ((strcmp(arguments->common.outputFilePath, "") != 0) || arguments->common.isWriteToFileEnabled)
-	{
-		fprintf(stderr, "Error: This application does not support saving outputs to file.\n");
-		exit(EXIT_FAILURE);
-	}
-
 	if (arguments->common.outputSelect != 0)
 	{
 		fprintf(stderr, "Error: Output select option not supported.\n");
@@ -148,12 +233,6 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		exit(EXIT_FAILURE);
 	}
 
-	if (arguments->common.isBenchmarkingMode)
-	{
-		fprintf(stderr, "Error: Benchmarking mode not supported.\n");
-		exit(EXIT_FAILURE);
-	}
-
 	if (arguments->common.isHelpEnabled)
 	{
 		printUsage();
@@ -187,6 +266,428 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		arguments->emissivity = emissivity;
 	}
 
+	if (emissivityMapArg != NULL)
+	{
+		int ret = snprintf(arguments->emissivityMapPath, kCommonConstantMaxCharsPerFilepath, "%s", emissivityMapArg);
+
+		if ((ret < 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read emissivity map file path from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (emissivitySweepArg != NULL)
+	{
+		char	sweepBuffer[kCommonConstantMaxCharsPerLine];
+		char *	startToken;
+		char *	stopToken;
+		char *	stepToken;
+		double	start;
+		double	stop;
+		double	step;
+
+		snprintf(sweepBuffer, sizeof(sweepBuffer), "%s", emissivitySweepArg);
+		startToken = strtok(sweepBuffer, ":");
+		stopToken = strtok(NULL, ":");
+		stepToken = strtok(NULL, ":");
+
+		if ((stepToken == NULL) || (strtok(NULL, ":") != NULL) ||
+			(parseDoubleChecked(startToken, &start) != kCommonConstantReturnTypeSuccess) ||
+			(parseDoubleChecked(stopToken, &stop) != kCommonConstantReturnTypeSuccess) ||
+			(parseDoubleChecked(stepToken, &step) != kCommonConstantReturnTypeSuccess))
+		{
+			fprintf(stderr, "Error: The emissivity sweep must be of the form start:stop:step.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((start <= 0) || (stop > 1) || (stop < start) || (step <= 0))
+		{
+			fprintf(stderr, "Error: The emissivity sweep must satisfy 0 < start <= stop <= 1 and step > 0.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((emissivityArg != NULL) || (emissivityMapArg != NULL))
+		{
+			fprintf(stderr, "Error: The emissivity sweep cannot be combined with an emissivity or emissivity map.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		/*
+		 *	Tolerate rounding in (stop - start) / step so that the stop value is
+		 *	included when it lies on the grid.
+		 */
+		arguments->emissivitySweepStart = start;
+		arguments->emissivitySweepStep = step;
+		arguments->emissivitySweepCount = (size_t)floor((stop - start) / step + 1e-6) + 1;
+	}
+
+	if (rootPrecisionArg != NULL)
+	{
+		if (strcmp(rootPrecisionArg, "exact") == 0)
+		{
+			arguments->rootPrecision = kMLX90640RootPrecisionExact;
+		}
+		else if (strcmp(rootPrecisionArg, "float") == 0)
+		{
+			arguments->rootPrecision = kMLX90640RootPrecisionFloat;
+		}
+		else if (strcmp(rootPrecisionArg, "fast") == 0)
+		{
+			arguments->rootPrecision = kMLX90640RootPrecisionFast;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The root precision must be one of 'exact', 'float' or 'fast'.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	The fast roots reinterpret the bits of the radicand, which is only
+	 *	meaningful for particle values.
+	 */
+	if ((arguments->rootPrecision == kMLX90640RootPrecisionFast) &&
+		(!disableQuantisationError || (emissivityArg == NULL) || (emissivityMapArg != NULL)))
+	{
+		fprintf(stderr, "Error: The fast root precision requires -q and a scalar emissivity (-e).\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (precisionArg != NULL)
+	{
+		if (strcmp(precisionArg, "float") == 0)
+		{
+			arguments->precision = kMLX90640PrecisionFloat;
+		}
+		else if (strcmp(precisionArg, "double") == 0)
+		{
+			arguments->precision = kMLX90640PrecisionDouble;
+		}
+		else if (strcmp(precisionArg, "fixed") == 0)
+		{
+			arguments->precision = kMLX90640PrecisionFixedPoint;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The precision must be one of 'float', 'double' or 'fixed'.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (formatArg != NULL)
+	{
+		if (strcmp(formatArg, "text") == 0)
+		{
+			arguments->outputFormat = kOutputFormatText;
+		}
+		else if (strcmp(formatArg, "fixed") == 0)
+		{
+			arguments->outputFormat = kOutputFormatFixed;
+		}
+		else if (strcmp(formatArg, "f32") == 0)
+		{
+			arguments->outputFormat = kOutputFormatFloat32;
+		}
+		else if (strcmp(formatArg, "i16") == 0)
+		{
+			arguments->outputFormat = kOutputFormatInt16;
+		}
+		else if (strcmp(formatArg, "jsonl") == 0)
+		{
+			arguments->outputFormat = kOutputFormatJSONLines;
+		}
+		else if (strcmp(formatArg, "sparse") == 0)
+		{
+			arguments->outputFormat = kOutputFormatSparse;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The format must be one of 'text', 'fixed', 'f32', 'i16', 'jsonl' or 'sparse'.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (inputFormatArg != NULL)
+	{
+		if (strcmp(inputFormatArg, "csv") == 0)
+		{
+			arguments->inputFormat = kFrameReaderFormatCSV;
+		}
+		else if (strcmp(inputFormatArg, "bin") == 0)
+		{
+			arguments->inputFormat = kFrameReaderFormatBinary;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The input format must be one of 'csv' or 'bin'.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (prefetchDepthArg != NULL)
+	{
+		int	depth;
+
+		if ((parseIntChecked(prefetchDepthArg, &depth) != kCommonConstantReturnTypeSuccess) || (depth < 0))
+		{
+			fprintf(stderr, "Error: The prefetch depth must be a non-negative number of frames.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->prefetchDepth = depth;
+	}
+
+	if (filesInFlightArg != NULL)
+	{
+		int	count;
+
+		if ((parseIntChecked(filesInFlightArg, &count) != kCommonConstantReturnTypeSuccess) || (count < 1) || (count > kBatchReaderConstantMaxDepth))
+		{
+			fprintf(stderr, "Error: The files in flight must be between 1 and %d.\n", kBatchReaderConstantMaxDepth);
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->filesInFlight = count;
+	}
+
+	if (((sparseThresholdArg != NULL) || (keyframeIntervalArg != NULL)) && (arguments->outputFormat != kOutputFormatSparse))
+	{
+		fprintf(stderr, "Error: The sparse threshold and keyframe interval can only be set with -f sparse.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (sparseThresholdArg != NULL)
+	{
+		double	threshold;
+
+		if ((parseDoubleChecked(sparseThresholdArg, &threshold) != kCommonConstantReturnTypeSuccess) || (threshold < 0))
+		{
+			fprintf(stderr, "Error: The sparse threshold must be a non-negative temperature change in Celsius.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->sparseThreshold = threshold;
+	}
+
+	if (keyframeIntervalArg != NULL)
+	{
+		int	interval;
+
+		if ((parseIntChecked(keyframeIntervalArg, &interval) != kCommonConstantReturnTypeSuccess) || (interval <= 0))
+		{
+			fprintf(stderr, "Error: The keyframe interval must be a positive number of frames.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->keyframeInterval = interval;
+	}
+
+	/*
+	 *	Only the formats that write every frame write to the output file, the
+	 *	text formats go to stdout. JSON Lines go to stdout without -o.
+	 */
+	if (arguments->outputFormat >= kOutputFormatFloat32)
+	{
+		if ((arguments->outputFormat != kOutputFormatJSONLines) && (strcmp(arguments->common.outputFilePath, "") == 0))
+		{
+			fprintf(stderr, "Error: Binary formats are written to the output file, use -o to specify it.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		if (arguments->emissivitySweepCount > 0)
+		{
+			fprintf(stderr, "Error: Formats that write every frame cannot be combined with an emissivity sweep.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+	else if ((strcmp(arguments->common.outputFilePath, "") != 0) || arguments->common.isWriteToFileEnabled)
+	{
+		fprintf(stderr, "Error: Only formats that write every frame (-f f32, i16, jsonl or sparse) can be saved to a file.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((arguments->precision == kMLX90640PrecisionFixedPoint) && ((emissivityMapArg != NULL) || (emissivitySweepArg != NULL)))
+	{
+		fprintf(stderr, "Error: The fixed-point kernel supports a single emissivity only.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (((i2cFrequencyArg != NULL) || (refreshRateArg != NULL)) && !arguments->isReplayEnabled)
+	{
+		fprintf(stderr, "Error: The I2C frequency and refresh rate can only be emulated with -R.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (i2cFrequencyArg != NULL)
+	{
+		int	frequency;
+
+		if ((parseIntChecked(i2cFrequencyArg, &frequency) != kCommonConstantReturnTypeSuccess) || (frequency <= 0))
+		{
+			fprintf(stderr, "Error: The I2C frequency must be a positive integer (kHz).\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		arguments->i2cFrequency = frequency;
+	}
+
+	if (refreshRateArg != NULL)
+	{
+		double	rate;
+
+		/*
+		 *	The sensor supports 0.5 Hz (code 0) and every power of two from 1 Hz (code 1) to 64 Hz (code 7).
+		 */
+		if (parseDoubleChecked(refreshRateArg, &rate) == kCommonConstantReturnTypeSuccess)
+		{
+			for (int code = 0; code <= 7; code++)
+			{
+				if (rate == ldexp(0.5, code))
+				{
+					arguments->refreshRateCode = code;
+				}
+			}
+		}
+
+		if (arguments->refreshRateCode < 0)
+		{
+			fprintf(stderr, "Error: The refresh rate must be one of 0.5, 1, 2, 4, 8, 16, 32 or 64 Hz.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (latencyReportPeriodArg != NULL)
+	{
+		if ((parseDoubleChecked(latencyReportPeriodArg, &arguments->latencyReportPeriod) != kCommonConstantReturnTypeSuccess) ||
+			(arguments->latencyReportPeriod < 0))
+		{
+			fprintf(stderr, "Error: The latency report period must be a non-negative number of seconds.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (traceArg != NULL)
+	{
+		int ret = snprintf(arguments->tracePath, kCommonConstantMaxCharsPerFilepath, "%s", traceArg);
+
+		if ((ret <= 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read trace file path from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (metricsArg != NULL)
+	{
+		int ret = snprintf(arguments->metricsPath, kCommonConstantMaxCharsPerFilepath, "%s", metricsArg);
+
+		if ((ret <= 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read metrics file path from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (shmInputArg != NULL)
+	{
+		int ret = snprintf(arguments->shmInputName, kCommonConstantMaxCharsPerFilepath, "%s", shmInputArg);
+
+		if ((ret <= 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read shared memory ring name from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		/*
+		 *	The frames of the ring are consumed, so they cannot be converted again.
+		 */
+		if (arguments->isReplayEnabled || (arguments->common.numberOfMonteCarloIterations > 1))
+		{
+			fprintf(stderr, "Error: Frames from a shared memory ring cannot be replayed (-R) or converted repeatedly (-M).\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (shmOutputArg != NULL)
+	{
+		int ret = snprintf(arguments->shmOutputName, kCommonConstantMaxCharsPerFilepath, "%s", shmOutputArg);
+
+		if ((ret <= 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read shared memory ring name from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		if ((shmInputArg == NULL) || (arguments->emissivitySweepCount > 0))
+		{
+			fprintf(stderr, "Error: Temperature frames are published to a shared memory ring only with -I and without -s.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (serverArg != NULL)
+	{
+		int ret = snprintf(arguments->serverSocketPath, kCommonConstantMaxCharsPerFilepath, "%s", serverArg);
+
+		if ((ret <= 0) || (ret >= kCommonConstantMaxCharsPerFilepath))
+		{
+			fprintf(stderr, "Error: Could not read server socket path from command line arguments.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+
+		/*
+		 *	The server converts the frames of its requests with the float or
+		 *	double kernel and replies with f32 records.
+		 */
+		if (arguments->isReplayEnabled || (shmInputArg != NULL) || (arguments->emissivitySweepCount > 0) ||
+			(arguments->precision == kMLX90640PrecisionFixedPoint) || (arguments->outputFormat != kOutputFormatText) ||
+			(arguments->common.numberOfMonteCarloIterations > 1))
+		{
+			fprintf(stderr, "Error: The server cannot be combined with -R, -I, -s, -P fixed, -f or -M.\n");
+			printUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	/*
+	 *	Only the raw frame input of -i is read ahead.
+	 */
+	if ((arguments->prefetchDepth > 0) && (arguments->isReplayEnabled || (shmInputArg != NULL) || (serverArg != NULL)))
+	{
+		fprintf(stderr, "Error: The prefetch depth cannot be combined with -R, -I or -U.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
 	if (pixelArg != NULL)
 	{
 		int pixel;
@@ -215,6 +716,35 @@ getCommandLineArguments(int argc, char *  argv[], CommandLineArguments *  argume
 		strcpy(arguments->rawDataPath, arguments->common.inputFilePath);
 	}
 
+	/*
+	 *	Frames from stdin are converted once, as they arrive.
+	 */
+	if ((strcmp(arguments->rawDataPath, "-") == 0) && (arguments->common.numberOfMonteCarloIterations > 1))
+	{
+		fprintf(stderr, "Error: Frames from stdin cannot be converted repeatedly (-M).\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	/*
+	 *	A directory is read as the concatenation of its recordings in file
+	 *	name order, which the batch reader already reads ahead.
+	 */
+	arguments->isRawDataDirectory = (stat(arguments->rawDataPath, &status) == 0) && S_ISDIR(status.st_mode);
+	if (arguments->isRawDataDirectory && (arguments->isReplayEnabled || (arguments->prefetchDepth > 0)))
+	{
+		fprintf(stderr, "Error: A directory of recordings cannot be combined with -R or -A.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((filesInFlightArg != NULL) && !arguments->isRawDataDirectory)
+	{
+		fprintf(stderr, "Error: The files in flight can only be set when -i is a directory.\n");
+		printUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
 	return kCommonConstantReturnTypeSuccess;
 }
 
@@ -271,3 +801,189 @@ readUint16DataFromCSV(uint16_t *  dest, int line, int maxLen, const char *  file
 	 */
 	return -1;
 }
+
+
+/**
+ *	@brief	Parse a single emissivity map entry, either a value or `lower:upper` uniform distribution bounds.
+ *
+ *	@param	token		: entry to parse
+ *	@param	emissivity	: pointer to store the parsed emissivity
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType
+parseEmissivityMapEntry(char *  token, float *  emissivity)
+{
+	char *	upperToken;
+	double	lower;
+	double	upper;
+
+	while (isspace((unsigned char)*token))
+	{
+		token++;
+	}
+
+	for (char *  end = token + strlen(token); (end > token) && isspace((unsigned char)end[-1]); end--)
+	{
+		end[-1] = '\0';
+	}
+
+	upperToken = strchr(token, ':');
+	if (upperToken != NULL)
+	{
+		*upperToken++ = '\0';
+	}
+
+	if (parseDoubleChecked(token, &lower) != kCommonConstantReturnTypeSuccess)
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (upperToken == NULL)
+	{
+		upper = lower;
+	}
+	else if ((parseDoubleChecked(upperToken, &upper) != kCommonConstantReturnTypeSuccess) || (upper < lower))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((lower <= 0) || (upper > 1))
+	{
+		return kCommonConstantReturnTypeError;
+	}
+
+	*emissivity = (upper == lower) ? (float)lower : UxHwFloatUniformDist(lower, upper);
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+CommonConstantReturnType
+readEmissivityMap(float *  dest, const char *  filename)
+{
+	FILE *		file;
+	size_t		filenameLength = strlen(filename);
+	size_t		index = 0;
+
+	file = fopen(filename, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Failed to open emissivity map file\n");
+		return kCommonConstantReturnTypeError;
+	}
+
+	if ((filenameLength > 4) && (strcmp(&filename[filenameLength - 4], ".bin") == 0))
+	{
+		/*
+		 *	Binary maps hold either one little-endian float32 per pixel, or one
+		 *	(lower, upper) pair per pixel. The file size tells them apart, so one
+		 *	byte more than the larger map is read to detect longer files.
+		 */
+		uint8_t	bytes[2 * kMLX90640ConstantFrameBufferSize * sizeof(float) + 1];
+		float	values[2 * kMLX90640ConstantFrameBufferSize];
+		size_t	size = fread(bytes, 1, sizeof(bytes), file);
+		size_t	count = size / sizeof(float);
+
+		fclose(file);
+
+		if ((size != kMLX90640ConstantFrameBufferSize * sizeof(float)) && (size != 2 * kMLX90640ConstantFrameBufferSize * sizeof(float)))
+		{
+			fprintf(stderr, "Error: Binary emissivity map must hold exactly %d or %d float32 values.\n", kMLX90640ConstantFrameBufferSize, 2 * kMLX90640ConstantFrameBufferSize);
+			return kCommonConstantReturnTypeError;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint8_t *	value = &bytes[i * sizeof(float)];
+			uint32_t	bits = value[0] | (value[1] << 8) | (value[2] << 16) | ((uint32_t)value[3] << 24);
+
+			memcpy(&values[i], &bits, sizeof(bits));
+		}
+
+		for (index = 0; index < kMLX90640ConstantFrameBufferSize; index++)
+		{
+			float	lower = (count == kMLX90640ConstantFrameBufferSize) ? values[index] : values[2 * index];
+			float	upper = (count == kMLX90640ConstantFrameBufferSize) ? values[index] : values[2 * index + 1];
+
+			if (!(lower > 0) || !(upper <= 1) || (upper < lower))
+			{
+				fprintf(stderr, "Error: Invalid emissivity for pixel %zu in emissivity map.\n", index);
+				return kCommonConstantReturnTypeError;
+			}
+
+			dest[index] = (upper == lower) ? lower : UxHwFloatUniformDist(lower, upper);
+		}
+
+		return kCommonConstantReturnTypeSuccess;
+	}
+
+	/*
+	 *	CSV maps hold one entry per pixel in the same row-major layout as the
+	 *	`--print-all-temperatures` output, typically 24 lines of 32 entries.
+	 */
+	char	lineBuffer[kCommonConstantMaxCharsPerLine];
+
+	while (fgets(lineBuffer, sizeof(lineBuffer), file))
+	{
+		for (char *  token = strtok(lineBuffer, ",\n"); token != NULL; token = strtok(NULL, ",\n"))
+		{
+			if (strspn(token, " \t\r") == strlen(token))
+			{
+				continue;
+			}
+
+			if (index >= kMLX90640ConstantFrameBufferSize)
+			{
+				fprintf(stderr, "Error: Emissivity map holds more than %d entries.\n", kMLX90640ConstantFrameBufferSize);
+				fclose(file);
+				return kCommonConstantReturnTypeError;
+			}
+
+			if (parseEmissivityMapEntry(token, &dest[index]) != kCommonConstantReturnTypeSuccess)
+			{
+				fprintf(stderr, "Error: Invalid emissivity for pixel %zu in emissivity map.\n", index);
+				fclose(file);
+				return kCommonConstantReturnTypeError;
+			}
+
+			index++;
+		}
+	}
+
+	fclose(file);
+
+	if (index != kMLX90640ConstantFrameBufferSize)
+	{
+		fprintf(stderr, "Error: Emissivity map holds %zu entries, expected %d.\n", index, kMLX90640ConstantFrameBufferSize);
+		return kCommonConstantReturnTypeError;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+uint64_t
+getMonotonicTimeNanoseconds(void)
+{
+	struct timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+uint64_t
+computeChecksum(const void *  data, size_t size)
+{
+	const uint8_t *	bytes = data;
+	uint64_t	hash = 0xCBF29CE484222325ULL;
+
+	/*
+	 *	64-bit FNV-1a.
+	 */
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
@@ -27,6 +27,9 @@
 #include <inttypes.h>
 
 #include "common.h"
+#include "mlx90640-conversion.h"
+#include "frame-writer.h"
+#include "frame-reader.h"
 
 typedef enum
 {
@@ -36,6 +39,8 @@ typedef enum
 	kMLX90640ConstantFrameWidth		= 32,
 	kMLX90640ConstantFrameHeight		= 24,
 	kMLX90640ConstantTaShift		= 8,
+	kMLX90640ConstantCacheLineSize		= 64,
+	kMLX90640ConstantRootBlockSize		= 4, /* Pixels per block of the vectorized fast-root kernel */
 } MLX90640Constant;
 
 typedef struct CommandLineArguments
@@ -44,9 +49,32 @@ typedef struct CommandLineArguments
 
 	char				eeDataPath[kCommonConstantMaxCharsPerFilepath];
 	char				rawDataPath[kCommonConstantMaxCharsPerFilepath];
+	char				emissivityMapPath[kCommonConstantMaxCharsPerFilepath];
+	char				tracePath[kCommonConstantMaxCharsPerFilepath];
+	char				metricsPath[kCommonConstantMaxCharsPerFilepath];
+	char				shmInputName[kCommonConstantMaxCharsPerFilepath];
+	char				shmOutputName[kCommonConstantMaxCharsPerFilepath];
+	char				serverSocketPath[kCommonConstantMaxCharsPerFilepath];
 	bool				modelQuantizationError;
 	bool				printAllTemperatures;
 	float				emissivity;
+	float				emissivitySweepStart;
+	float				emissivitySweepStep;
+	size_t				emissivitySweepCount;
+	MLX90640RootPrecision		rootPrecision;
+	MLX90640Precision		precision;
+	OutputFormat			outputFormat;
+	FrameReaderFormat		inputFormat;
+	unsigned int			prefetchDepth;
+	bool				isRawDataDirectory;
+	unsigned int			filesInFlight;
+	float				sparseThreshold;
+	unsigned int			keyframeInterval;
+	bool				isReplayEnabled;
+	unsigned int			i2cFrequency;
+	int				refreshRateCode;
+	bool				isPerformanceCountersEnabled;
+	double				latencyReportPeriod;
 	unsigned int			pixel;
 } CommandLineArguments;
 
@@ -77,5 +105,33 @@ CommonConstantReturnType getCommandLineArguments(int argc, char *  argv[], Comma
  */
 int	readUint16DataFromCSV(uint16_t *  dest, int line, int maxLen, const char *  filename);
 
+/**
+ *	@brief	Read a per-pixel emissivity map. Files ending in `.bin` are read as little-endian float32,
+ *		either one value per pixel or one (lower, upper) pair per pixel. All other files are read
+ *		as CSV with one entry per pixel in row-major order, each entry either a value (`0.95`) or
+ *		uniform distribution bounds (`0.93:0.97`).
+ *
+ *	@param	dest			: destination of per-pixel emissivities (kMLX90640ConstantFrameBufferSize values)
+ *	@param	filename		: emissivity map file path
+ *	@return				: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+CommonConstantReturnType	readEmissivityMap(float *  dest, const char *  filename);
+
+/**
+ *	@brief	Read the monotonic clock.
+ *
+ *	@return	uint64_t		: time in nanoseconds since an arbitrary fixed point
+ */
+uint64_t	getMonotonicTimeNanoseconds(void);
+
+/**
+ *	@brief	Checksum of a buffer, to compare results across builds.
+ *
+ *	@param	data			: buffer to checksum
+ *	@param	size			: size of the buffer in bytes
+ *	@return	uint64_t		: 64-bit FNV-1a hash of the buffer
+ */
+uint64_t	computeChecksum(const void *  data, size_t size);
+
 #define kMLX90640ConstantEmissivityDistributionLowerBound	(0.93)
 #define kMLX90640ConstantEmissivityDistributionUpperBound	(0.97)
\ No newline at end of file
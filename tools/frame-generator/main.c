@@ -0,0 +1,738 @@
+/*
+ *	Copyright (c) 2023, Signaloid.
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <MLX90640_API.h>
+#include "utilities.h"
+#include "common.h"
+#include "shm-ring.h"
+
+typedef enum
+{
+	kFrameGeneratorConstantDefaultFrameCount	= 100,
+	kFrameGeneratorConstantDefaultHotSpotCount	= 3,
+	kFrameGeneratorConstantMaxHotSpots		= 64,
+	kFrameGeneratorConstantRootIterations		= 4,
+} FrameGeneratorConstant;
+
+typedef enum
+{
+	kFrameGeneratorFormatCSV	= 0,
+	kFrameGeneratorFormatBinary	= 1,
+	kFrameGeneratorFormatSharedMemory	= 2,
+} FrameGeneratorFormat;
+
+typedef struct FrameGeneratorArguments
+{
+	CommonCommandLineArguments	common;
+
+	const char *			eeDataPath;
+	const char *			templatePath;
+	const char *			groundTruthPath;
+	FrameGeneratorFormat		format;
+	size_t				frameCount;
+	size_t				hotSpotCount;
+	double				emissivity;
+	double				noise;
+	double				ambientStart;
+	double				ambientStop;
+	uint64_t			seed;
+} FrameGeneratorArguments;
+
+/*
+ *	A Gaussian hot spot moving at constant velocity and bouncing off the edges of the frame.
+ */
+typedef struct HotSpot
+{
+	double	x;
+	double	y;
+	double	vx;
+	double	vy;
+	double	radius;
+	double	amplitude;
+} HotSpot;
+
+/*
+ *	Frame-wide quantities of the forward conversion, as in MLX90640_CalculateTo.
+ */
+typedef struct FrameConstants
+{
+	double	vdd;
+	double	ta;
+	double	taTr;
+	double	gain;
+	double	irDataCP[2];
+	double	alphaCorrR[4];
+	double	ktaScale;
+	double	kvScale;
+	double	alphaScale;
+	uint8_t	mode;
+	uint16_t	subPage;
+} FrameConstants;
+
+static uint16_t	eeData[kMLX90640ConstantEEDataBufferSize];
+static uint16_t	templateFrame[kMLX90640ConstantRawFrameBufferSize];
+static uint16_t	rawDataFrame[kMLX90640ConstantRawFrameBufferSize];
+static double	scene[kMLX90640ConstantFrameBufferSize];
+static HotSpot	hotSpots[kFrameGeneratorConstantMaxHotSpots];
+
+/**
+ *	@brief	Print out command line usage.
+ */
+static void	printFrameGeneratorUsage(void);
+
+/**
+ *	@brief	Get command line arguments.
+ *
+ *	@param	argc		: argument count from main()
+ *	@param	argv		: argument vector from main()
+ *	@param	arguments	: Pointer to struct to store arguments
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	getFrameGeneratorArguments(int argc, char *  argv[], FrameGeneratorArguments *  arguments);
+
+/**
+ *	@brief	Next value of a splitmix64 generator.
+ *
+ *	@param	state		: Generator state.
+ *	@return	uint64_t	: Uniformly distributed 64-bit value.
+ */
+static uint64_t	randomNext(uint64_t *  state);
+
+/**
+ *	@brief	Uniformly distributed value in [lower, upper).
+ *
+ *	@param	state		: Generator state.
+ *	@param	lower		: Lower bound.
+ *	@param	upper		: Upper bound.
+ *	@return	double		: Random value.
+ */
+static double	randomUniform(uint64_t *  state, double lower, double upper);
+
+/**
+ *	@brief	Standard normally distributed value (Box-Muller).
+ *
+ *	@param	state		: Generator state.
+ *	@return	double		: Random value.
+ */
+static double	randomGaussian(uint64_t *  state);
+
+/**
+ *	@brief	Render the ground-truth object temperatures of one frame: a background gradient that
+ *		follows the ambient temperature plus the hot spots, which are then advanced by one frame.
+ *
+ *	@param	ambient		: Ambient temperature of the frame in Celsius.
+ *	@param	hotSpotCount	: Number of hot spots.
+ *	@param	to		: Destination of kMLX90640ConstantFrameBufferSize temperatures in Celsius.
+ */
+static void	renderScene(double ambient, size_t hotSpotCount, double *  to);
+
+/**
+ *	@brief	Set the PTAT auxiliary word of `frame` so that MLX90640_GetTa() returns approximately `ta`.
+ *
+ *	@param	frame		: Raw frame whose auxiliary data are modified.
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@param	ta		: Ambient temperature in Celsius.
+ */
+static void	setAmbientTemperature(uint16_t *  frame, const paramsMLX90640 *  params, double ta);
+
+/**
+ *	@brief	Compute the frame-wide quantities of the forward conversion from the auxiliary data of `frame`.
+ *
+ *	@param	frame		: Raw frame with auxiliary data in place.
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@param	emissivity	: Emissivity the frame will be converted with.
+ *	@param	constants	: Destination of the frame constants.
+ */
+static void	calculateFrameConstants(uint16_t *  frame, const paramsMLX90640 *  params, double emissivity, FrameConstants *  constants);
+
+/**
+ *	@brief	Invert the To calculation of one pixel.
+ *
+ *	@param	params		: Parameters of MLX90640 sensor.
+ *	@param	constants	: Frame constants.
+ *	@param	pixelNumber	: Pixel index.
+ *	@param	emissivity	: Emissivity the frame will be converted with.
+ *	@param	to		: Object temperature in Celsius.
+ *	@return	double		: Raw (not yet quantized) ADC value of the pixel.
+ */
+static double	invertPixel(const paramsMLX90640 *  params, const FrameConstants *  constants, int pixelNumber, double emissivity, double to);
+
+/**
+ *	@brief	Append one raw frame to `file` as a CSV line or as little-endian uint16 values.
+ *
+ *	@param	file		: Output file.
+ *	@param	frame		: Raw frame.
+ *	@param	format		: Output format.
+ *	@return			: `kCommonConstantReturnTypeSuccess` if successful, else `kCommonConstantReturnTypeError`
+ */
+static CommonConstantReturnType	writeFrame(FILE *  file, const uint16_t *  frame, FrameGeneratorFormat format);
+
+int
+main(int argc, char *  argv[])
+{
+	FrameGeneratorArguments	arguments;
+	paramsMLX90640		mlx90640Params = { 0 };
+	FrameConstants		constants;
+	FILE *			output = NULL;
+	ShmRing			ring;
+	FILE *			groundTruth = NULL;
+	uint64_t		noiseState;
+
+	if (getFrameGeneratorArguments(argc, argv, &arguments))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	if (readUint16DataFromCSV(eeData, 0, kMLX90640ConstantEEDataBufferSize, arguments.eeDataPath) < kMLX90640ConstantEEDataBufferSize)
+	{
+		fprintf(stderr, "Error in reading sensor ee data\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MLX90640_ExtractParameters(eeData, &mlx90640Params))
+	{
+		fprintf(stderr, "Error in extracting parameters from EE\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 *	The auxiliary data (supply voltage, gain, compensation pixels) and the
+	 *	control register of the generated frames come from a recorded frame.
+	 */
+	if (readUint16DataFromCSV(templateFrame, 0, kMLX90640ConstantRawFrameBufferSize, arguments.templatePath) < kMLX90640ConstantRawFrameBufferSize)
+	{
+		fprintf(stderr, "Error in reading template raw frame\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (arguments.format == kFrameGeneratorFormatSharedMemory)
+	{
+		if (shmRingCreate(&ring, arguments.common.outputFilePath, sizeof(rawDataFrame), kShmRingConstantDefaultSlotCount) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: Could not create shared memory ring '%s'.\n", arguments.common.outputFilePath);
+			exit(EXIT_FAILURE);
+		}
+	}
+	else
+	{
+		output = fopen(arguments.common.outputFilePath, (arguments.format == kFrameGeneratorFormatBinary) ? "wb" : "w");
+		if (output == NULL)
+		{
+			fprintf(stderr, "Error: Could not open output file '%s'.\n", arguments.common.outputFilePath);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (arguments.groundTruthPath != NULL)
+	{
+		groundTruth = fopen(arguments.groundTruthPath, "w");
+		if (groundTruth == NULL)
+		{
+			fprintf(stderr, "Error: Could not open ground truth file '%s'.\n", arguments.groundTruthPath);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/*
+	 *	The scene and the noise use separate streams, so that the same seed gives
+	 *	the same scene at any noise level.
+	 */
+	noiseState = arguments.seed ^ 0x9E3779B97F4A7C15ULL;
+	for (size_t h = 0; h < arguments.hotSpotCount; h++)
+	{
+		hotSpots[h] = (HotSpot) {
+			.x		= randomUniform(&arguments.seed, 0, kMLX90640ConstantFrameWidth - 1),
+			.y		= randomUniform(&arguments.seed, 0, kMLX90640ConstantFrameHeight - 1),
+			.vx		= randomUniform(&arguments.seed, -0.5, 0.5),
+			.vy		= randomUniform(&arguments.seed, -0.5, 0.5),
+			.radius		= randomUniform(&arguments.seed, 1.5, 4.0),
+			.amplitude	= randomUniform(&arguments.seed, 10.0, 80.0),
+		};
+	}
+
+	for (size_t f = 0; f < arguments.frameCount; f++)
+	{
+		double	progress = (arguments.frameCount > 1) ? (double)f / (arguments.frameCount - 1) : 0;
+		double	ambient = arguments.ambientStart + (arguments.ambientStop - arguments.ambientStart) * progress;
+
+		memcpy(rawDataFrame, templateFrame, sizeof(rawDataFrame));
+		rawDataFrame[833] = f & 1;
+		setAmbientTemperature(rawDataFrame, &mlx90640Params, ambient);
+		calculateFrameConstants(rawDataFrame, &mlx90640Params, arguments.emissivity, &constants);
+
+		renderScene(ambient, arguments.hotSpotCount, scene);
+
+		/*
+		 *	All pixels are generated, although only those of the frame's sub-page
+		 *	are converted, as the sensor RAM holds both sub-pages.
+		 */
+		for (int i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+		{
+			double	raw = invertPixel(&mlx90640Params, &constants, i, arguments.emissivity, scene[i]) + arguments.noise * randomGaussian(&noiseState);
+
+			rawDataFrame[i] = (uint16_t)(int16_t)fmax(INT16_MIN, fmin(INT16_MAX, round(raw)));
+		}
+
+		if (arguments.format == kFrameGeneratorFormatSharedMemory)
+		{
+			void *	slot;
+			size_t	attempt = 0;
+
+			while ((slot = shmRingAcquireWrite(&ring)) == NULL)
+			{
+				shmRingBackOff(&attempt);
+			}
+			memcpy(slot, rawDataFrame, sizeof(rawDataFrame));
+			shmRingCommitWrite(&ring);
+		}
+		else if (writeFrame(output, rawDataFrame, arguments.format) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error in writing raw frame %zu\n", f);
+			exit(EXIT_FAILURE);
+		}
+
+		if (groundTruth != NULL)
+		{
+			for (size_t i = 0; i < kMLX90640ConstantFrameBufferSize; i++)
+			{
+				fprintf(groundTruth, (i == 0) ? "%.4f" : ",%.4f", scene[i]);
+			}
+			fprintf(groundTruth, "\n");
+		}
+	}
+
+	if (arguments.format == kFrameGeneratorFormatSharedMemory)
+	{
+		shmRingEnd(&ring);
+		shmRingClose(&ring);
+	}
+	else if (fclose(output) != 0)
+	{
+		fprintf(stderr, "Error in writing output file\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((groundTruth != NULL) && (fclose(groundTruth) != 0))
+	{
+		fprintf(stderr, "Error in writing ground truth file\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
+
+static void
+printFrameGeneratorUsage(void)
+{
+	fprintf(stderr, "MLX90640 synthetic raw frame generator\n");
+	fprintf(stderr, "\n");
+	printCommonUsage();
+	fprintf(
+		stderr,
+		"	[-c, --ee-data <path to sensor ee constants file: str (Default: 'EEPROM-calibration-data.csv')>]\n"
+		"	[-n, --frames <number of sub-page frames : int (Default: %d)>]\n"
+		"	[-f, --format <csv|bin|shm : str (Default: 'csv')>] (Output format, 'bin' is 834 little-endian uint16 per frame, 'shm' a shared memory ring named by '-o'.)\n"
+		"	[-g, --ground-truth <path to ground truth CSV : str>] (Write the scene temperatures of every frame.)\n"
+		"	[-e, --emissivity <emissivity the frames will be converted with : float (Default: 0.95)>]\n"
+		"	[-N, --noise <RMS noise in ADC counts : float (Default: 1)>]\n"
+		"	[-A, --ambient <start:stop ambient temperature in Celsius : float:float (Default: '25:35')>]\n"
+		"	[-H, --hot-spots <number of moving hot spots : int, range = [0,%d] (Default: %d)>]\n"
+		"	[-x, --seed <random seed : int (Default: 1)>]\n"
+		"\n"
+		"The template frame (auxiliary data and control register) is read from '-i' (Default: 'raw-frame-data.csv'),\n"
+		"the generated frames are written to '-o'.\n",
+		kFrameGeneratorConstantDefaultFrameCount,
+		kFrameGeneratorConstantMaxHotSpots,
+		kFrameGeneratorConstantDefaultHotSpotCount);
+	fprintf(stderr, "\n");
+}
+
+static CommonConstantReturnType
+getFrameGeneratorArguments(int argc, char *  argv[], FrameGeneratorArguments *  arguments)
+{
+	const char *	frameCountArg = NULL;
+	const char *	formatArg = NULL;
+	const char *	emissivityArg = NULL;
+	const char *	noiseArg = NULL;
+	const char *	ambientArg = NULL;
+	const char *	hotSpotsArg = NULL;
+	const char *	seedArg = NULL;
+	int		value;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-braces"
+	*arguments = (FrameGeneratorArguments) {
+		.common		= (CommonCommandLineArguments) { 0 },
+		.eeDataPath	= "EEPROM-calibration-data.csv",
+		.templatePath	= "raw-frame-data.csv",
+		.groundTruthPath	= NULL,
+		.format		= kFrameGeneratorFormatCSV,
+		.frameCount	= kFrameGeneratorConstantDefaultFrameCount,
+		.hotSpotCount	= kFrameGeneratorConstantDefaultHotSpotCount,
+		.emissivity	= 0.95,
+		.noise		= 1.0,
+		.ambientStart	= 25.0,
+		.ambientStop	= 35.0,
+		.seed		= 1,
+	};
+#pragma GCC diagnostic pop
+
+	DemoOption	options[] = {
+		{ .opt = "c", .optAlternative = "ee-data",	.hasArg = true, .foundArg = &arguments->eeDataPath,	.foundOpt = NULL },
+		{ .opt = "n", .optAlternative = "frames",	.hasArg = true, .foundArg = &frameCountArg,		.foundOpt = NULL },
+		{ .opt = "f", .optAlternative = "format",	.hasArg = true, .foundArg = &formatArg,		.foundOpt = NULL },
+		{ .opt = "g", .optAlternative = "ground-truth",	.hasArg = true, .foundArg = &arguments->groundTruthPath,	.foundOpt = NULL },
+		{ .opt = "e", .optAlternative = "emissivity",	.hasArg = true, .foundArg = &emissivityArg,		.foundOpt = NULL },
+		{ .opt = "N", .optAlternative = "noise",	.hasArg = true, .foundArg = &noiseArg,		.foundOpt = NULL },
+		{ .opt = "A", .optAlternative = "ambient",	.hasArg = true, .foundArg = &ambientArg,		.foundOpt = NULL },
+		{ .opt = "H", .optAlternative = "hot-spots",	.hasArg = true, .foundArg = &hotSpotsArg,		.foundOpt = NULL },
+		{ .opt = "x", .optAlternative = "seed",		.hasArg = true, .foundArg = &seedArg,		.foundOpt = NULL },
+		{ 0 },
+	};
+
+	if (parseArgs(argc, argv, &arguments->common, options) != 0)
+	{
+		fprintf(stderr, "Parsing command line arguments failed\n");
+		printFrameGeneratorUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (arguments->common.isHelpEnabled)
+	{
+		printFrameGeneratorUsage();
+		exit(EXIT_SUCCESS);
+	}
+
+	if (strcmp(arguments->common.outputFilePath, "") == 0)
+	{
+		fprintf(stderr, "Error: An output file must be given with -o.\n");
+		printFrameGeneratorUsage();
+		return kCommonConstantReturnTypeError;
+	}
+
+	if (strcmp(arguments->common.inputFilePath, "") != 0)
+	{
+		arguments->templatePath = arguments->common.inputFilePath;
+	}
+
+	if (frameCountArg != NULL)
+	{
+		if ((parseIntChecked(frameCountArg, &value) != kCommonConstantReturnTypeSuccess) || (value <= 0))
+		{
+			fprintf(stderr, "Error: The number of frames must be a positive integer.\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+		arguments->frameCount = value;
+	}
+
+	if (formatArg != NULL)
+	{
+		if (strcmp(formatArg, "csv") == 0)
+		{
+			arguments->format = kFrameGeneratorFormatCSV;
+		}
+		else if (strcmp(formatArg, "bin") == 0)
+		{
+			arguments->format = kFrameGeneratorFormatBinary;
+		}
+		else if (strcmp(formatArg, "shm") == 0)
+		{
+			arguments->format = kFrameGeneratorFormatSharedMemory;
+		}
+		else
+		{
+			fprintf(stderr, "Error: The format must be one of 'csv', 'bin' or 'shm'.\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (emissivityArg != NULL)
+	{
+		if ((parseDoubleChecked(emissivityArg, &arguments->emissivity) != kCommonConstantReturnTypeSuccess) ||
+			(arguments->emissivity <= 0) || (arguments->emissivity > 1))
+		{
+			fprintf(stderr, "Error: The emissivity must be in (0, 1].\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (noiseArg != NULL)
+	{
+		if ((parseDoubleChecked(noiseArg, &arguments->noise) != kCommonConstantReturnTypeSuccess) || (arguments->noise < 0))
+		{
+			fprintf(stderr, "Error: The noise must be non-negative.\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (ambientArg != NULL)
+	{
+		char	ambientBuffer[kCommonConstantMaxCharsPerLine];
+		char *	startToken;
+		char *	stopToken;
+
+		snprintf(ambientBuffer, sizeof(ambientBuffer), "%s", ambientArg);
+		startToken = strtok(ambientBuffer, ":");
+		stopToken = strtok(NULL, ":");
+
+		if ((stopToken == NULL) || (strtok(NULL, ":") != NULL) ||
+			(parseDoubleChecked(startToken, &arguments->ambientStart) != kCommonConstantReturnTypeSuccess) ||
+			(parseDoubleChecked(stopToken, &arguments->ambientStop) != kCommonConstantReturnTypeSuccess))
+		{
+			fprintf(stderr, "Error: The ambient temperature must be of the form start:stop.\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	if (hotSpotsArg != NULL)
+	{
+		if ((parseIntChecked(hotSpotsArg, &value) != kCommonConstantReturnTypeSuccess) || (value < 0) || (value > kFrameGeneratorConstantMaxHotSpots))
+		{
+			fprintf(stderr, "Error: The number of hot spots must be in [0, %d].\n", kFrameGeneratorConstantMaxHotSpots);
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+		arguments->hotSpotCount = value;
+	}
+
+	if (seedArg != NULL)
+	{
+		if (parseIntChecked(seedArg, &value) != kCommonConstantReturnTypeSuccess)
+		{
+			fprintf(stderr, "Error: The seed must be an integer.\n");
+			printFrameGeneratorUsage();
+			return kCommonConstantReturnTypeError;
+		}
+		arguments->seed = (uint64_t)value;
+	}
+
+	return kCommonConstantReturnTypeSuccess;
+}
+
+static uint64_t
+randomNext(uint64_t *  state)
+{
+	uint64_t	z = (*state += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return z ^ (z >> 31);
+}
+
+static double
+randomUniform(uint64_t *  state, double lower, double upper)
+{
+	return lower + (upper - lower) * ((randomNext(state) >> 11) * 0x1.0p-53);
+}
+
+static double
+randomGaussian(uint64_t *  state)
+{
+	double	u = randomUniform(state, 0, 1);
+	double	v = randomUniform(state, 0, 1);
+
+	return sqrt(-2 * log1p(-u)) * cos(2 * M_PI * v);
+}
+
+static void
+renderScene(double ambient, size_t hotSpotCount, double *  to)
+{
+	for (size_t y = 0; y < kMLX90640ConstantFrameHeight; y++)
+	{
+		for (size_t x = 0; x < kMLX90640ConstantFrameWidth; x++)
+		{
+			/*
+			 *	Background a few degrees below ambient with a diagonal gradient.
+			 */
+			double	t = ambient - 5 + 6.0 * x / (kMLX90640ConstantFrameWidth - 1) + 3.0 * y / (kMLX90640ConstantFrameHeight - 1);
+
+			for (size_t h = 0; h < hotSpotCount; h++)
+			{
+				double	dx = x - hotSpots[h].x;
+				double	dy = y - hotSpots[h].y;
+
+				t += hotSpots[h].amplitude * exp(-(dx * dx + dy * dy) / (2 * hotSpots[h].radius * hotSpots[h].radius));
+			}
+
+			to[y * kMLX90640ConstantFrameWidth + x] = t;
+		}
+	}
+
+	for (size_t h = 0; h < hotSpotCount; h++)
+	{
+		hotSpots[h].x += hotSpots[h].vx;
+		hotSpots[h].y += hotSpots[h].vy;
+
+		if ((hotSpots[h].x < 0) || (hotSpots[h].x > kMLX90640ConstantFrameWidth - 1))
+		{
+			hotSpots[h].vx = -hotSpots[h].vx;
+		}
+		if ((hotSpots[h].y < 0) || (hotSpots[h].y > kMLX90640ConstantFrameHeight - 1))
+		{
+			hotSpots[h].vy = -hotSpots[h].vy;
+		}
+	}
+}
+
+static void
+setAmbientTemperature(uint16_t *  frame, const paramsMLX90640 *  params, double ta)
+{
+	double	vdd = MLX90640_GetVdd(frame, params);
+	double	ptat = (int16_t)frame[800];
+	double	ptatArt;
+
+	/*
+	 *	MLX90640_GetTa() computes ta = (ptatArt / (1 + KvPTAT * (vdd - 3.3)) - vPTAT25) / KtPTAT + 25
+	 *	with ptatArt = ptat / (ptat * alphaPTAT + frame[768]) * 2^18. Solve for frame[768].
+	 */
+	ptatArt = ((ta - 25) * params->KtPTAT + params->vPTAT25) * (1 + params->KvPTAT * (vdd - 3.3));
+	frame[768] = (uint16_t)(int16_t)round(ptat * 262144.0 / ptatArt - ptat * params->alphaPTAT);
+}
+
+static void
+calculateFrameConstants(uint16_t *  frame, const paramsMLX90640 *  params, double emissivity, FrameConstants *  constants)
+{
+	double	ta4;
+	double	tr4;
+	double	cpCompensation;
+
+	constants->subPage = frame[833];
+	constants->vdd = MLX90640_GetVdd(frame, params);
+	constants->ta = MLX90640_GetTa(frame, params);
+
+	/*
+	 *	The reflected temperature the conversion example uses, see `kMLX90640ConstantTaShift`.
+	 */
+	ta4 = pow(constants->ta + 273.15, 4);
+	tr4 = pow(constants->ta - kMLX90640ConstantTaShift + 273.15, 4);
+	constants->taTr = tr4 - (tr4 - ta4) / emissivity;
+
+	constants->ktaScale = POW2(params->ktaScale);
+	constants->kvScale = POW2(params->kvScale);
+	constants->alphaScale = POW2(params->alphaScale);
+
+	constants->alphaCorrR[0] = 1 / (1 + params->ksTo[0] * 40);
+	constants->alphaCorrR[1] = 1;
+	constants->alphaCorrR[2] = (1 + params->ksTo[1] * params->ct[2]);
+	constants->alphaCorrR[3] = constants->alphaCorrR[2] * (1 + params->ksTo[2] * (params->ct[3] - params->ct[2]));
+
+	constants->gain = (double)params->gainEE / (int16_t)frame[778];
+	constants->mode = (frame[832] & MLX90640_CTRL_MEAS_MODE_MASK) >> 5;
+
+	cpCompensation = (1 + params->cpKta * (constants->ta - 25)) * (1 + params->cpKv * (constants->vdd - 3.3));
+	constants->irDataCP[0] = (int16_t)frame[776] * constants->gain - params->cpOffset[0] * cpCompensation;
+	constants->irDataCP[1] = (int16_t)frame[808] * constants->gain - params->cpOffset[1] * cpCompensation;
+	if (constants->mode != params->calibrationModeEE)
+	{
+		constants->irDataCP[1] -= params->ilChessC[0] * cpCompensation;
+	}
+}
+
+static double
+invertPixel(const paramsMLX90640 *  params, const FrameConstants *  constants, int pixelNumber, double emissivity, double to)
+{
+	double	toK4 = pow(to + 273.15, 4);
+	double	alphaCompensated;
+	double	irData = 0;
+	double	firstTo = to;
+	double	kta;
+	double	kv;
+	int	ilPattern;
+	int	conversionPattern;
+	int	range;
+
+	alphaCompensated = SCALEALPHA * constants->alphaScale / params->alpha[pixelNumber];
+	alphaCompensated = alphaCompensated * (1 + params->KsTa * (constants->ta - 25));
+
+	/*
+	 *	The final To depends on the range selected by the first estimate of To,
+	 *	which in turn depends on the compensated IR signal. Iterate until both
+	 *	are consistent, starting from the first estimate equal to the target.
+	 */
+	for (int i = 0; i < kFrameGeneratorConstantRootIterations; i++)
+	{
+		double	Sx;
+
+		range = (firstTo < params->ct[1]) ? 0 : (firstTo < params->ct[2]) ? 1 : (firstTo < params->ct[3]) ? 2 : 3;
+		irData = (toK4 - constants->taTr) * alphaCompensated * constants->alphaCorrR[range] * (1 + params->ksTo[range] * (firstTo - params->ct[range]));
+
+		Sx = params->ksTo[1] * sqrt(sqrt(alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * constants->taTr)));
+		firstTo = sqrt(sqrt(irData / (alphaCompensated * (1 - params->ksTo[1] * 273.15) + Sx) + constants->taTr)) - 273.15;
+	}
+
+	/*
+	 *	Undo the emissivity, gradient, interleave/chess and offset compensation.
+	 */
+	irData = irData * emissivity + params->tgc * constants->irDataCP[constants->subPage];
+
+	if (constants->mode != params->calibrationModeEE)
+	{
+		ilPattern = pixelNumber / 32 - (pixelNumber / 64) * 2;
+		conversionPattern = ((pixelNumber + 2) / 4 - (pixelNumber + 3) / 4 + (pixelNumber + 1) / 4 - pixelNumber / 4) * (1 - 2 * ilPattern);
+		irData = irData - params->ilChessC[2] * (2 * ilPattern - 1) + params->ilChessC[1] * conversionPattern;
+	}
+
+	kta = params->kta[pixelNumber] / constants->ktaScale;
+	kv = params->kv[pixelNumber] / constants->kvScale;
+	irData = irData + params->offset[pixelNumber] * (1 + kta * (constants->ta - 25)) * (1 + kv * (constants->vdd - 3.3));
+
+	return irData / constants->gain;
+}
+
+static CommonConstantReturnType
+writeFrame(FILE *  file, const uint16_t *  frame, FrameGeneratorFormat format)
+{
+	if (format == kFrameGeneratorFormatBinary)
+	{
+		uint8_t	bytes[kMLX90640ConstantRawFrameBufferSize * sizeof(uint16_t)];
+
+		for (size_t i = 0; i < kMLX90640ConstantRawFrameBufferSize; i++)
+		{
+			bytes[2 * i] = frame[i] & 0xFF;
+			bytes[2 * i + 1] = frame[i] >> 8;
+		}
+
+		return (fwrite(bytes, sizeof(bytes), 1, file) == 1) ? kCommonConstantReturnTypeSuccess : kCommonConstantReturnTypeError;
+	}
+
+	for (size_t i = 0; i < kMLX90640ConstantRawFrameBufferSize; i++)
+	{
+		if (fprintf(file, (i == 0) ? "%u" : ",%u", frame[i]) < 0)
+		{
+			return kCommonConstantReturnTypeError;
+		}
+	}
+
+	return (fprintf(file, "\n") < 0) ? kCommonConstantReturnTypeError : kCommonConstantReturnTypeSuccess;
+}